@@ -0,0 +1,541 @@
+// OBJ -> .bin converter, same output as src/python/obj2bin.py
+// Keep in sync with src/mesh.h
+
+const MESH_MAGIC = "3DVB";
+const MESH_VERSION = 2;
+const MESH_HEADER_SIZE = 148;
+// Offset of nb_lods, lods_offset in the header
+const MESH_LODS_FIELD = 84;
+const MESH_FLAG_QUANTIZED = 0x1;
+const MESH_FLAG_EDGES16 = 0x2;
+const MESH_FLAG_CROSS_VARINT = 0x4;
+const MESH_FLAG_STRIPS = 0x8;
+const CHUNK_POINTS = 512;
+// Coarser levels target nbPoints / ratio vertices, models with fewer edges get none
+const LOD_RATIOS = [4, 16];
+const LOD_MIN_EDGES = 2000;
+const LOD_MIN_POINTS = 64;
+// Face indices are uint16 in the adjacency table, bigger models get no faces
+const NO_FACE = 0xFFFF;
+// Even the coarsest level would have too many faces to store them
+const MAX_FACES = NO_FACE * LOD_RATIOS[LOD_RATIOS.length - 1];
+// Cells per axis of the vertex order curve
+const MORTON_BITS = 10;
+
+// 1-based, negative counts back from the last vertex read, v/vt/vn keeps v
+function objIndex(token, nbPoints, lineNumber) {
+  let i = parseInt(token.split('/')[0], 10);
+  if (Number.isNaN(i)) throw new Error(`line ${lineNumber}: bad vertex index ${token}`);
+  i = i < 0 ? i + nbPoints : i - 1;
+  if (i < 0) throw new Error(`line ${lineNumber}: vertex index ${token} out of range`);
+  return i;
+}
+
+// Parse OBJ file content and return {points, edges, faces}. Edges are
+// deduplicated as number keys, lower end * 2^32 + upper end.
+function parseOBJ(text) {
+  const points = [];
+  const keys = new Set();
+  let faces = [];
+  let nbFaces = 0;
+  let highest = -1;
+  const lines = text.split('\n');
+  for (let n = 0; n < lines.length; n++) {
+    const parts = lines[n].trim().split(/\s+/);
+    const tag = parts[0];
+    if (tag === 'v') {
+      if (parts.length < 4) throw new Error(`line ${n + 1}: vertex with less than 3 coordinates`);
+      points.push([parseFloat(parts[1]), parseFloat(parts[2]), parseFloat(parts[3])]);
+    } else if (tag === 'f' || tag === 'l') {
+      const idx = parts.slice(1).map(part => objIndex(part, points.length, n + 1));
+      for (const i of idx) if (i > highest) highest = i;
+      // Faces are closed, polylines are not
+      const count = tag === 'f' ? idx.length : idx.length - 1;
+      for (let i = 0; i < count; i++) {
+        const a = idx[i], b = idx[(i + 1) % idx.length];
+        keys.add(a < b ? a * 4294967296 + b : b * 4294967296 + a);
+      }
+      if (tag === 'f') {
+        nbFaces++;
+        if (nbFaces <= MAX_FACES) faces.push(idx);
+      }
+    }
+  }
+  if (highest >= points.length) throw new Error(`vertex index ${highest + 1} out of range, ${points.length} vertices`);
+  if (nbFaces > MAX_FACES) faces = [];
+  const edges = Array.from(keys).sort((a, b) => a - b).map(k => [Math.floor(k / 4294967296), k % 4294967296]);
+  return { points, edges, faces };
+}
+
+// Bit i of v at bit 3i
+function spread(v) {
+  let out = 0;
+  for (let bit = 0; bit < MORTON_BITS; bit++) out |= ((v >> bit) & 1) << (3 * bit);
+  return out;
+}
+
+const SPREAD = Array.from({ length: 1 << MORTON_BITS }, (_, v) => spread(v));
+
+// Vertices along a Morton curve over the bounding box, so that the vertices
+// of a chunk are close in space and most edges stay inside one. Ties keep
+// the OBJ order, faces keep their winding. Modelers often write connected
+// vertices next to each other already: the OBJ order stays when the curve
+// does not leave fewer edges across chunks.
+function reorder(points, edges, faces = [], chunkPoints = CHUNK_POINTS) {
+  if (!points.length) return { points, edges, faces };
+  const bboxMin = [...points[0]], bboxMax = [...points[0]];
+  for (const p of points) {
+    for (let i = 0; i < 3; i++) {
+      if (p[i] < bboxMin[i]) bboxMin[i] = p[i];
+      if (p[i] > bboxMax[i]) bboxMax[i] = p[i];
+    }
+  }
+  const extent = [0, 1, 2].map(i => (bboxMax[i] - bboxMin[i]) || 1.0);
+  const last = (1 << MORTON_BITS) - 1;
+  const codes = points.map(p =>
+    SPREAD[Math.trunc((p[0] - bboxMin[0]) / extent[0] * last)] |
+    SPREAD[Math.trunc((p[1] - bboxMin[1]) / extent[1] * last)] << 1 |
+    SPREAD[Math.trunc((p[2] - bboxMin[2]) / extent[2] * last)] << 2);
+  const order = points.map((_, i) => i).sort((a, b) => codes[a] - codes[b] || a - b);
+  const remap = new Array(points.length);
+  order.forEach((old, index) => { remap[old] = index; });
+  const curveEdges = edges.map(([a, b]) => [Math.min(remap[a], remap[b]), Math.max(remap[a], remap[b])])
+    .sort((e, f) => e[0] - f[0] || e[1] - f[1]);
+  if (locality(curveEdges, chunkPoints).cross >= locality(edges, chunkPoints).cross) return { points, edges, faces };
+  return { points: order.map(i => points[i]), edges: curveEdges, faces: faces.map(face => face.map(i => remap[i])) };
+}
+
+// Mean index distance between the ends of the edges, and share of the edges
+// across two chunks, which are read and projected one by one
+function locality(edges, chunkPoints = CHUNK_POINTS) {
+  if (!edges.length) return { span: 0, cross: 0 };
+  let span = 0, cross = 0;
+  for (const [a, b] of edges) {
+    span += b - a;
+    if (Math.floor(a / chunkPoints) !== Math.floor(b / chunkPoints)) cross++;
+  }
+  return { span: span / edges.length, cross: cross / edges.length };
+}
+
+// Greedy cover of the edges by chains, each edge once: a chain starts at the
+// lowest vertex with an odd number of edges left, then at the lowest with
+// any, and goes on to the lowest neighbor left
+function edgeStrips(edges) {
+  const neighbors = new Map();
+  for (const [a, b] of edges) {
+    if (!neighbors.has(a)) neighbors.set(a, []);
+    if (!neighbors.has(b)) neighbors.set(b, []);
+    neighbors.get(a).push(b);
+    neighbors.get(b).push(a);
+  }
+  const left = new Map(), first = new Map();
+  for (const [v, n] of neighbors) {
+    n.sort((x, y) => x - y);
+    left.set(v, n.length);
+    first.set(v, 0);
+  }
+  const used = new Set();
+  const key = (v, w) => v < w ? v * 4294967296 + w : w * 4294967296 + v;
+
+  function walk(v) {
+    const strip = [v];
+    // The number of vertices is a uint16
+    while (strip.length < 0xFFFF) {
+      const n = neighbors.get(v);
+      let i = first.get(v);
+      while (i < n.length && used.has(key(v, n[i]))) i++;
+      first.set(v, i);
+      if (i === n.length) break;
+      const w = n[i];
+      used.add(key(v, w));
+      left.set(v, left.get(v) - 1);
+      left.set(w, left.get(w) - 1);
+      strip.push(w);
+      v = w;
+    }
+    return strip;
+  }
+
+  const strips = [];
+  const vertices = Array.from(neighbors.keys()).sort((x, y) => x - y);
+  for (const odd of [true, false]) {
+    for (const v of vertices) {
+      while (left.get(v) > 0 && (left.get(v) % 2 === 1 || !odd)) strips.push(walk(v));
+    }
+  }
+  return strips;
+}
+
+// Edges along the strips, in order
+function stripEdges(strips) {
+  const edges = [];
+  for (const s of strips) {
+    for (let i = 0; i + 1 < s.length; i++) edges.push([s[i], s[i + 1]]);
+  }
+  return edges;
+}
+
+function stripsSize(strips) {
+  return strips.reduce((size, s) => size + 2 * (s.length + 1), 0);
+}
+
+function writeStrips(view, offset, strips, base) {
+  for (const s of strips) {
+    view.setUint16(offset, s.length, true); offset += 2;
+    for (const v of s) {
+      view.setUint16(offset, v - base, true); offset += 2;
+    }
+  }
+  return offset;
+}
+
+// Edges inside one chunk go to its bucket, the others to the cross list
+function bucketEdges(nbPoints, edges, chunkPoints) {
+  const nbChunks = Math.ceil(nbPoints / chunkPoints);
+  const buckets = Array.from({ length: nbChunks }, () => []);
+  const cross = [];
+  const sorted = edges.slice().sort((e, f) => e[0] - f[0] || e[1] - f[1]);
+  for (const [a, b] of sorted) {
+    if (Math.floor(a / chunkPoints) === Math.floor(b / chunkPoints)) {
+      buckets[Math.floor(a / chunkPoints)].push([a, b]);
+    } else {
+      cross.push([a, b]);
+    }
+  }
+  return { buckets, cross };
+}
+
+// int16 positions around the bounding box center, same float32 math as mesh.c
+function quantize(points) {
+  const f32 = Math.fround;
+  const bboxMin = [0, 0, 0], bboxMax = [0, 0, 0], center = [0, 0, 0], scale = [0, 0, 0];
+  for (let i = 0; i < 3; i++) {
+    if (points.length) {
+      bboxMin[i] = f32(points.reduce((m, p) => Math.min(m, p[i]), Infinity));
+      bboxMax[i] = f32(points.reduce((m, p) => Math.max(m, p[i]), -Infinity));
+    }
+    center[i] = f32(f32(bboxMin[i] + bboxMax[i]) * 0.5);
+    scale[i] = f32((bboxMax[i] - bboxMin[i]) / 65534) || 1.0;
+  }
+  const quantized = points.map(p => p.map((v, i) =>
+    Math.max(-32767, Math.min(32767, Math.floor((v - center[i]) / scale[i] + 0.5)))));
+  return { quantized, bboxMin, bboxMax, scale, center };
+}
+
+// Sphere around the bounding box center through the farthest vertex, and
+// the mean of the vertices, same sums as the Python converter
+function boundingSphere(points, center) {
+  if (!points.length) return { sphere: [0, 0, 0, 0], centroid: [0, 0, 0] };
+  let far = 0;
+  const total = [0, 0, 0];
+  for (const p of points) {
+    const dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+    const d = dx * dx + dy * dy + dz * dz;
+    if (d > far) far = d;
+    for (let i = 0; i < 3; i++) total[i] += p[i];
+  }
+  return {
+    sphere: [...center, Math.fround(Math.sqrt(far))],
+    centroid: total.map(t => Math.fround(t / points.length)),
+  };
+}
+
+function varint(bytes, value) {
+  while (value >= 0x80) {
+    bytes.push((value & 0x7F) | 0x80);
+    value = Math.floor(value / 128);
+  }
+  bytes.push(value);
+}
+
+// Newell's method, works for non planar polygons too
+function faceNormal(points, face) {
+  const n = [0, 0, 0];
+  for (let i = 0; i < face.length; i++) {
+    const p = points[face[i]], q = points[face[(i + 1) % face.length]];
+    n[0] += (p[1] - q[1]) * (p[2] + q[2]);
+    n[1] += (p[2] - q[2]) * (p[0] + q[0]);
+    n[2] += (p[0] - q[0]) * (p[1] + q[1]);
+  }
+  const length = Math.sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  return n.map(v => length > 0 ? v / length : 0);
+}
+
+// Up to 255 triangles, their count is a byte
+function fan(face) {
+  const out = [];
+  for (let i = 1; i + 1 < face.length && i < 256; i++) out.push([face[0], face[i], face[i + 1]]);
+  return out;
+}
+
+// Fans of the faces in face order
+function triangles(faces) {
+  return faces.flatMap(fan);
+}
+
+// Edge -> its two faces, edges of one face or of more than two get none
+function edgeFaces(faces) {
+  const adjacent = new Map();
+  faces.forEach((face, f) => {
+    for (let i = 0; i < face.length; i++) {
+      const a = face[i], b = face[(i + 1) % face.length];
+      const key = a < b ? `${a},${b}` : `${b},${a}`;
+      if (!adjacent.has(key)) adjacent.set(key, []);
+      adjacent.get(key).push(f);
+    }
+  });
+  return adjacent;
+}
+
+// v2 mesh with no LOD, offsets relative to its start
+function encodeMesh(points, edges, chunkPoints = CHUNK_POINTS, faces = [], strips = true) {
+  let { buckets, cross } = bucketEdges(points.length, edges, chunkPoints);
+  const nbChunks = buckets.length;
+  const { quantized, bboxMin, bboxMax, scale, center } = quantize(points);
+  const { sphere, centroid } = boundingSphere(points, center);
+  let flags = MESH_FLAG_QUANTIZED | MESH_FLAG_EDGES16;
+  if (points.length > 65536) flags |= MESH_FLAG_CROSS_VARINT;
+  if (strips) flags |= MESH_FLAG_STRIPS;
+
+  const nbChunkEdges = edges.length - cross.length;
+  let crossBytes = [];
+  let chunkStrips = [], crossStrips = [];
+  if (strips) {
+    // The stored edge order is the order along the strips
+    chunkStrips = buckets.map(edgeStrips);
+    buckets = chunkStrips.map(stripEdges);
+  }
+  if (flags & MESH_FLAG_CROSS_VARINT) {
+    let previous = 0;
+    for (const [a, b] of cross) {
+      varint(crossBytes, a - previous);
+      varint(crossBytes, b - a);
+      previous = a;
+    }
+  } else if (strips) {
+    crossStrips = edgeStrips(cross);
+    cross = stripEdges(crossStrips);
+  }
+  const pointsOffset = MESH_HEADER_SIZE;
+  const chunksOffset = pointsOffset + Math.ceil(points.length * 6 / 4) * 4;
+  const boxesOffset = chunksOffset + (nbChunks + 1) * 4;
+  const stripsOffset = boxesOffset + nbChunks * 12;
+  const edgesOffset = stripsOffset + (strips ? (nbChunks + 1) * 4 : 0);
+  const edgesSize = strips ? chunkStrips.reduce((size, s) => size + stripsSize(s), 0) : nbChunkEdges * 4;
+  const crossOffset = edgesOffset + Math.ceil(edgesSize / 4) * 4;
+  const crossSize = (flags & MESH_FLAG_CROSS_VARINT) ? crossBytes.length : strips ? stripsSize(crossStrips) : cross.length * 4;
+  if (faces.length >= NO_FACE) faces = [];
+  const facesOffset = Math.ceil((crossOffset + crossSize) / 4) * 4;
+  const adjacencyOffset = facesOffset + faces.length * 8;
+  const tris = faces.length && points.length <= 65536 ? triangles(faces) : [];
+  const trianglesOffset = adjacencyOffset + (faces.length ? edges.length * 4 : 0);
+  const size = faces.length ? trianglesOffset + Math.ceil(tris.length * 6 / 4) * 4 : facesOffset;
+  const buffer = new ArrayBuffer(size);
+  const view = new DataView(buffer);
+  let offset = 0;
+  for (let i = 0; i < 4; i++) view.setUint8(offset++, MESH_MAGIC.charCodeAt(i));
+  view.setUint16(offset, MESH_VERSION, true); offset += 2;
+  view.setUint16(offset, MESH_HEADER_SIZE, true); offset += 2;
+  for (const field of [flags, points.length, edges.length, chunkPoints, nbChunks,
+                       pointsOffset, chunksOffset, edgesOffset, cross.length, crossOffset]) {
+    view.setUint32(offset, field, true); offset += 4;
+  }
+  for (const field of [...bboxMin, ...bboxMax, ...scale]) {
+    view.setFloat32(offset, field, true); offset += 4;
+  }
+  view.setUint32(offset, 0, true); offset += 4;  // nb_lods
+  view.setUint32(offset, 0, true); offset += 4;  // lods_offset
+  view.setUint32(offset, faces.length, true); offset += 4;
+  view.setUint32(offset, faces.length ? facesOffset : 0, true); offset += 4;
+  view.setUint32(offset, faces.length ? adjacencyOffset : 0, true); offset += 4;
+  view.setUint32(offset, tris.length, true); offset += 4;
+  view.setUint32(offset, tris.length ? trianglesOffset : 0, true); offset += 4;
+  view.setUint32(offset, strips ? stripsOffset : 0, true); offset += 4;
+  view.setUint32(offset, nbChunks ? boxesOffset : 0, true); offset += 4;
+  for (const field of [...sphere, ...centroid]) {
+    view.setFloat32(offset, field, true); offset += 4;
+  }
+  for (const q of quantized) {
+    for (const v of q) {
+      view.setInt16(offset, v, true); offset += 2;
+    }
+  }
+  offset = chunksOffset;
+  let first = 0;
+  for (const bucket of buckets) {
+    view.setUint32(offset, first, true); offset += 4;
+    first += bucket.length;
+  }
+  view.setUint32(offset, first, true); offset += 4;
+  // Bounding box of the quantized vertices of each chunk
+  for (let chunk = 0; chunk < nbChunks; chunk++) {
+    const q = quantized.slice(chunk * chunkPoints, (chunk + 1) * chunkPoints);
+    for (const pick of [Math.min, Math.max]) {
+      for (let i = 0; i < 3; i++) {
+        view.setInt16(offset, q.reduce((m, v) => pick(m, v[i]), q[0][i]), true); offset += 2;
+      }
+    }
+  }
+  if (strips) {
+    let tokens = 0;
+    for (const s of chunkStrips) {
+      view.setUint32(offset, tokens, true); offset += 4;
+      tokens += stripsSize(s) / 2;
+    }
+    view.setUint32(offset, tokens, true); offset += 4;
+    chunkStrips.forEach((s, chunk) => { offset = writeStrips(view, offset, s, chunk * chunkPoints); });
+  } else {
+    buckets.forEach((bucket, chunk) => {
+      const base = chunk * chunkPoints;
+      for (const [a, b] of bucket) {
+        view.setUint16(offset, a - base, true); offset += 2;
+        view.setUint16(offset, b - base, true); offset += 2;
+      }
+    });
+  }
+  offset = crossOffset;
+  if (flags & MESH_FLAG_CROSS_VARINT) {
+    new Uint8Array(buffer, offset).set(crossBytes);
+  } else if (strips) {
+    writeStrips(view, offset, crossStrips, 0);
+  } else {
+    for (const [a, b] of cross) {
+      view.setUint16(offset, a, true); offset += 2;
+      view.setUint16(offset, b, true); offset += 2;
+    }
+  }
+
+  // int8 normal * 127, number of triangles, float32 plane offset: the
+  // viewpoint v sees the front of the face when dot(normal, v) >= offset
+  offset = facesOffset;
+  for (const face of faces) {
+    const q = faceNormal(points, face).map(v => Math.max(-127, Math.min(127, Math.floor(v * 127 + 0.5))));
+    const c = [0, 1, 2].map(k => face.reduce((sum, i) => sum + points[i][k], 0) / face.length);
+    view.setInt8(offset, q[0]);
+    view.setInt8(offset + 1, q[1]);
+    view.setInt8(offset + 2, q[2]);
+    view.setUint8(offset + 3, fan(face).length);
+    view.setFloat32(offset + 4, q[0] / 127 * c[0] + q[1] / 127 * c[1] + q[2] / 127 * c[2], true);
+    offset += 8;
+  }
+  if (faces.length) {
+    // Same order as the stored edges: chunk buckets, then cross edges
+    const adjacent = edgeFaces(faces);
+    for (const [a, b] of [...buckets.flat(), ...cross]) {
+      const f = adjacent.get(a < b ? `${a},${b}` : `${b},${a}`) || [];
+      view.setUint16(offset, f.length >= 1 && f.length <= 2 ? f[0] : NO_FACE, true);
+      view.setUint16(offset + 2, f.length === 2 ? f[1] : NO_FACE, true);
+      offset += 4;
+    }
+  }
+  for (const t of tris) {
+    for (const i of t) {
+      view.setUint16(offset, i, true); offset += 2;
+    }
+  }
+  return new Uint8Array(buffer);
+}
+
+function cellKeys(points, cells) {
+  const bboxMin = [0, 1, 2].map(i => points.reduce((m, p) => Math.min(m, p[i]), Infinity));
+  const extent = [0, 1, 2].map(i => (points.reduce((m, p) => Math.max(m, p[i]), -Infinity) - bboxMin[i]) || 1.0);
+  return points.map(p => [0, 1, 2].map(i =>
+    Math.min(cells - 1, Math.floor((p[i] - bboxMin[i]) / extent[i] * cells))).join(','));
+}
+
+// Vertex clustering: the vertices of each grid cell merge into their mean,
+// clusters are numbered in order of their first vertex. Faces keep their
+// distinct clusters, the ones left with less than 3 are dropped.
+function cluster(points, edges, faces, cells) {
+  const ids = new Map();
+  const remap = [];
+  const sums = [];
+  cellKeys(points, cells).forEach((key, i) => {
+    if (!ids.has(key)) {
+      ids.set(key, sums.length);
+      sums.push([0, 0, 0, 0]);
+    }
+    const c = ids.get(key);
+    remap.push(c);
+    const s = sums[c], p = points[i];
+    s[0] += p[0];
+    s[1] += p[1];
+    s[2] += p[2];
+    s[3] += 1;
+  });
+  const lodPoints = sums.map(s => [s[0] / s[3], s[1] / s[3], s[2] / s[3]]);
+  const lodEdges = new Set();
+  for (let [a, b] of edges) {
+    a = remap[a];
+    b = remap[b];
+    if (a !== b) lodEdges.add(a < b ? `${a},${b}` : `${b},${a}`);
+  }
+  const lodFaces = [];
+  const seen = new Set();
+  for (const face of faces) {
+    const lodFace = [];
+    for (const i of face) {
+      if (!lodFace.includes(remap[i])) lodFace.push(remap[i]);
+    }
+    const key = lodFace.slice().sort((a, b) => a - b).join(',');
+    if (lodFace.length >= 3 && !seen.has(key)) {
+      seen.add(key);
+      lodFaces.push(lodFace);
+    }
+  }
+  return { points: lodPoints, edges: Array.from(lodEdges).map(e => e.split(',').map(Number)), faces: lodFaces };
+}
+
+// Finest grid whose cluster count stays under each target
+function buildLods(points, edges, faces = []) {
+  const lods = [];
+  if (edges.length < LOD_MIN_EDGES) return lods;
+  for (const ratio of LOD_RATIOS) {
+    const target = Math.floor(points.length / ratio);
+    if (target < LOD_MIN_POINTS) break;
+    let low = 1, high = 1024;
+    while (low < high) {
+      const cells = Math.floor((low + high + 1) / 2);
+      if (new Set(cellKeys(points, cells)).size <= target) {
+        low = cells;
+      } else {
+        high = cells - 1;
+      }
+    }
+    const lod = cluster(points, edges, faces, low);
+    const previous = lods.length ? lods[lods.length - 1].edges : edges;
+    if (lod.edges.length > 0.75 * previous.length) break;
+    lods.push(lod);
+  }
+  return lods;
+}
+
+function createBin(points, edges, chunkPoints = CHUNK_POINTS, lods = true, faces = [], strips = true) {
+  const base = encodeMesh(points, edges, chunkPoints, faces, strips);
+  const levels = lods ? buildLods(points, edges, faces).map(lod => encodeMesh(lod.points, lod.edges, chunkPoints, lod.faces, strips)) : [];
+  if (!levels.length) return base.buffer;
+
+  // LOD table (offset, size) then the coarser meshes, finest first
+  const lodsOffset = base.length;
+  let size = lodsOffset + 8 * levels.length;
+  const table = [];
+  for (const level of levels) {
+    table.push([size, level.length]);
+    size += level.length;
+  }
+  const out = new Uint8Array(size);
+  const view = new DataView(out.buffer);
+  out.set(base);
+  view.setUint32(MESH_LODS_FIELD, levels.length, true);
+  view.setUint32(MESH_LODS_FIELD + 4, lodsOffset, true);
+  table.forEach(([offset, length], i) => {
+    view.setUint32(lodsOffset + 8 * i, offset, true);
+    view.setUint32(lodsOffset + 8 * i + 4, length, true);
+    out.set(levels[i], offset);
+  });
+  return out.buffer;
+}
+
+if (typeof module !== "undefined") {
+  module.exports = { parseOBJ, reorder, locality, bucketEdges, quantize, encodeMesh, cluster, buildLods, createBin };
+}
@@ -0,0 +1,213 @@
+#include "camera.h"
+#include "fixed.h"
+#include <math.h>
+#include <string.h>
+
+static void set_row(float *row, Vec3 axis, Vec3 eye, float k, float offset) {
+  row[0] = axis.x * k;
+  row[1] = axis.y * k;
+  row[2] = axis.z * k;
+  row[3] = -(axis.x * eye.x + axis.y * eye.y + axis.z * eye.z) * k + offset;
+}
+
+void camera_update(Camera *cam, float cam_theta, float cam_phi, float cam_dist, float scale, float cx, float cy, float cz) {
+  float ct = cosf(cam_theta), st = sinf(cam_theta);
+  float cp = cosf(cam_phi), sp = sinf(cam_phi);
+
+  cam->forward = (Vec3){cp * st, sp, cp * ct};
+  cam->right = (Vec3){ct, 0.0f, -st};
+  cam->up = (Vec3){-sp * st, cp, -sp * ct};
+  cam->eye = (Vec3){cx + cam_dist * cam->forward.x, cy + cam_dist * cam->forward.y, cz + cam_dist * cam->forward.z};
+  cam->viewpoint = (Vec3){cam->eye.x + FOV * cam->forward.x, cam->eye.y + FOV * cam->forward.y, cam->eye.z + FOV * cam->forward.z};
+  cam->scale = scale;
+
+  // Camera space is x = -right, y = up, z = -forward (looking at the center)
+  Vec3 x = {-cam->right.x, -cam->right.y, -cam->right.z};
+  Vec3 z = {-cam->forward.x, -cam->forward.y, -cam->forward.z};
+  set_row(cam->view[0], x, cam->eye, FOV * scale, 0.0f);
+  set_row(cam->view[1], cam->up, cam->eye, -FOV * scale, 0.0f);
+  set_row(cam->view[2], z, cam->eye, 1.0f, FOV);
+}
+
+void camera_axes(const Camera *cam, float *forward, float *right, float *up) {
+  forward[0] = cam->forward.x; forward[1] = cam->forward.y; forward[2] = cam->forward.z;
+  right[0] = cam->right.x; right[1] = cam->right.y; right[2] = cam->right.z;
+  up[0] = cam->up.x; up[1] = cam->up.y; up[2] = cam->up.z;
+}
+
+void camera_fit(float radius, float *cam_dist, float *scale) {
+  if (!(radius > 0.0f)) return;
+  // The viewpoint is d away from the center, the sphere is seen under a half
+  // angle of tangent radius / sqrt(d^2 - radius^2)
+  *cam_dist = 2.5f * radius;
+  float d = *cam_dist + FOV;
+  *scale = 0.9f * (HEIGHT / 2) * sqrtf(d * d - radius * radius) / (FOV * radius);
+}
+
+void camera_fly_through(Camera *cam, float t, Vec3 bbox_min, Vec3 bbox_max, float scale) {
+  // Straight line along the bounding box diagonal, from well outside one
+  // corner to well outside the opposite one, looking where it goes
+  Vec3 d = {bbox_max.x - bbox_min.x, bbox_max.y - bbox_min.y, bbox_max.z - bbox_min.z};
+  float len = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+  if (len <= 0.0f) {
+    d = (Vec3){0.0f, 0.0f, 1.0f};
+    len = 1.0f;
+  }
+  d = (Vec3){d.x / len, d.y / len, d.z / len};
+  float s = (t - 0.5f) * 2.0f * len;
+  Vec3 eye = {
+    0.5f * (bbox_min.x + bbox_max.x) + d.x * s,
+    0.5f * (bbox_min.y + bbox_max.y) + d.y * s,
+    0.5f * (bbox_min.z + bbox_max.z) + d.z * s
+  };
+
+  // forward points from the looked at center to the eye
+  float theta = atan2f(-d.x, -d.z);
+  float phi = asinf(-d.y);
+  camera_update(cam, theta, phi, 1.0f, scale, eye.x + d.x, eye.y + d.y, eye.z + d.z);
+}
+
+void camera_transform(const Camera *cam, Vec3 p, float *out) {
+  const float (*m)[4] = cam->view;
+  for (int r = 0; r < 3; r++) {
+    out[r] = m[r][0] * p.x + m[r][1] * p.y + m[r][2] * p.z + m[r][3];
+  }
+}
+
+void transform_and_project(const Camera *cam, const Vec3 *points, int nb_points, int (*projected)[2]) {
+  const float (*m)[4] = cam->view;
+  for (int i = 0; i < nb_points; i++) {
+    Vec3 p = points[i];
+    float X = m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3];
+    float Y = m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3];
+    float W = m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3];
+    if (W < CAMERA_NEAR) {
+      projected[i][0] = CLIP_BEHIND;
+      continue;
+    }
+    float inv = 1.0f / W;
+    projected[i][0] = camera_screen_coord(X * inv + WIDTH / 2);
+    projected[i][1] = camera_screen_coord(Y * inv + HEIGHT / 2);
+  }
+}
+
+void transform_and_project_keep(const Camera *cam, Vec3 *points, int nb_points, int (*projected)[2]) {
+  const float (*m)[4] = cam->view;
+  for (int i = 0; i < nb_points; i++) {
+    Vec3 p = points[i];
+    float X = m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3];
+    float Y = m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3];
+    float W = m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3];
+    if (W < CAMERA_NEAR) {
+      projected[i][0] = CLIP_BEHIND;
+      points[i] = (Vec3){0.0f, 0.0f, 0.0f};
+      continue;
+    }
+    float inv = 1.0f / W;
+    points[i] = (Vec3){X * inv, Y * inv, inv};
+    projected[i][0] = camera_screen_coord(points[i].x + WIDTH / 2);
+    projected[i][1] = camera_screen_coord(points[i].y + HEIGHT / 2);
+  }
+}
+
+bool camera_same_view(const Camera *cam, const Camera *base) {
+  // Same axes, and the eye moved along right and up only
+  if (memcmp(&cam->forward, &base->forward, sizeof(Vec3)) || memcmp(&cam->right, &base->right, sizeof(Vec3)) ||
+      memcmp(&cam->up, &base->up, sizeof(Vec3))) {
+    return false;
+  }
+  float w = cam->view[2][3], w0 = base->view[2][3];
+  return fabsf(w - w0) <= 1e-5f * (fabsf(w0) + 1.0f) && cam->scale > 0.0f && base->scale > 0.0f;
+}
+
+void project_kept(const Camera *cam, const Camera *base, const Vec3 *kept, int nb_points, int (*projected)[2]) {
+  // X / W = s * (X0 + d) / W with X0 the X of base, d = the move in base's units
+  float s = cam->scale / base->scale;
+  float dx = cam->view[0][3] / s - base->view[0][3];
+  float dy = cam->view[1][3] / s - base->view[1][3];
+  for (int i = 0; i < nb_points; i++) {
+    Vec3 k = kept[i];
+    if (k.z == 0.0f) {
+      projected[i][0] = CLIP_BEHIND;
+      continue;
+    }
+    projected[i][0] = camera_screen_coord(s * (k.x + dx * k.z) + WIDTH / 2);
+    projected[i][1] = camera_screen_coord(s * (k.y + dy * k.z) + HEIGHT / 2);
+  }
+}
+
+// Largest k such that every value * 2^k stays below 2^bits
+static int fit_shift(const float *values, int count, int bits) {
+  float max = 0.0f;
+  for (int i = 0; i < count; i++) {
+    if (fabsf(values[i]) > max) max = fabsf(values[i]);
+  }
+  int e;
+  frexpf(max, &e);
+  return bits - e;
+}
+
+void camera_fixed_view(const Camera *cam, Vec3 quant_center, Vec3 quant_scale, FixedView *fv) {
+  fixed_init();
+
+  // Fold the dequantization into the view: view * (c + s * q) = (view * s) q + view * c
+  float a[3][3], b[3];
+  for (int r = 0; r < 3; r++) {
+    const float *row = cam->view[r];
+    a[r][0] = row[0] * quant_scale.x;
+    a[r][1] = row[1] * quant_scale.y;
+    a[r][2] = row[2] * quant_scale.z;
+    b[r] = row[0] * quant_center.x + row[1] * quant_center.y + row[2] * quant_center.z + row[3];
+  }
+
+  // |q| < 2^15, so 3 terms of 2^14 * 2^15 plus an offset below 2^29 fit an int32
+  int xy = fit_shift(a[0], 6, 14);
+  int xy_b = fit_shift(b, 2, 29);
+  fv->xy_shift = xy < xy_b ? xy : xy_b;
+  int w = fit_shift(a[2], 3, 14);
+  int w_b = fit_shift(&b[2], 1, 29);
+  fv->w_shift = w < w_b ? w : w_b;
+
+  for (int r = 0; r < 3; r++) {
+    int k = r < 2 ? fv->xy_shift : fv->w_shift;
+    for (int c = 0; c < 3; c++) {
+      fv->m[r][c] = (int32_t)lroundf(ldexpf(a[r][c], k));
+    }
+    fv->b[r] = (int32_t)lroundf(ldexpf(b[r], k));
+  }
+  fv->near_w = (int32_t)lroundf(ldexpf(CAMERA_NEAR, fv->w_shift));
+  if (fv->near_w < 1) fv->near_w = 1;
+}
+
+static inline int32_t clamp_coord(int64_t v) {
+  const int64_t limit = SCREEN_COORD_LIMIT;
+  return v > limit ? limit : (v < -limit ? -limit : (int32_t)v);
+}
+
+void transform_and_project_fixed(const FixedView *fv, const uint8_t *points, int nb_points, int (*projected)[2]) {
+  const int32_t (*m)[3] = fv->m;
+  int base_shift = 62 + fv->xy_shift - fv->w_shift;
+  for (int i = 0; i < nb_points; i++) {
+    int16_t q[3];
+    memcpy(q, points + i * sizeof(q), sizeof(q));
+    int32_t X = m[0][0] * q[0] + m[0][1] * q[1] + m[0][2] * q[2] + fv->b[0];
+    int32_t Y = m[1][0] * q[0] + m[1][1] * q[1] + m[1][2] * q[2] + fv->b[1];
+    int32_t W = m[2][0] * q[0] + m[2][1] * q[1] + m[2][2] * q[2] + fv->b[2];
+
+    if (W < fv->near_w) {
+      projected[i][0] = CLIP_BEHIND;
+      continue;
+    }
+
+    // X / W = X * r >> (62 - n), plus the difference of scales between X and W
+    int n;
+    uint32_t r = fixed_recip((uint32_t)W, &n);
+    int shift = base_shift - n;
+    if (shift < 0) shift = 0;
+    if (shift > 62) shift = 62;
+    int32_t x = clamp_coord(((int64_t)X * r) >> shift);
+    int32_t y = clamp_coord(((int64_t)Y * r) >> shift);
+    projected[i][0] = x + WIDTH / 2;
+    projected[i][1] = y + HEIGHT / 2;
+  }
+}
@@ -0,0 +1,74 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include "vec3.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Build with FIXED_POINT=1 to project quantized models with integer math only
+#ifndef FIXED_POINT
+#define FIXED_POINT 0
+#endif
+
+#define WIDTH 320
+#define HEIGHT 240
+#define FOV 5.0f
+
+// Points with W below this are behind the near plane, their projection is
+// CLIP_BEHIND and the edges and triangles using them are clipped in camera
+// space.
+#define CAMERA_NEAR 0.1f
+#define CLIP_BEHIND INT32_MIN
+// Projected coordinates are clamped to +-2^24
+#define SCREEN_COORD_LIMIT (1 << 24)
+
+// Orbit camera around a center point, rebuilt once per frame.
+// view maps a world point to (X, Y, W) with the FOV and scale folded in,
+// the screen position is then (X / W + WIDTH / 2, Y / W + HEIGHT / 2).
+typedef struct {
+  float view[3][4];
+  Vec3 eye;
+  Vec3 viewpoint;   // center of the perspective, FOV behind the eye
+  Vec3 forward, right, up;
+  float scale;
+} Camera;
+
+// Fixed point view for int16 quantized vertices (world = center + q * scale).
+// X and Y are scaled by 2^xy_shift and W by 2^w_shift so that m * q + b fits
+// an int32 with as many bits as possible.
+typedef struct {
+  int32_t m[3][3];
+  int32_t b[3];
+  int xy_shift, w_shift;
+  int32_t near_w;    // CAMERA_NEAR in W units
+} FixedView;
+
+void camera_update(Camera *cam, float cam_theta, float cam_phi, float cam_dist, float scale, float cx, float cy, float cz);
+void camera_axes(const Camera *cam, float *forward, float *right, float *up);
+// Distance and scale at which a sphere of that radius around the center
+// fills 90% of the screen height, unchanged for a radius of 0
+void camera_fit(float radius, float *cam_dist, float *scale);
+void camera_fly_through(Camera *cam, float t, Vec3 bbox_min, Vec3 bbox_max, float scale);
+// Camera space (X, Y, W) of one point
+void camera_transform(const Camera *cam, Vec3 p, float *out);
+void transform_and_project(const Camera *cam, const Vec3 *points, int nb_points, int (*projected)[2]);
+// transform_and_project, then replaces each point by its (X / W, Y / W,
+// 1 / W), with 1 / W = 0 behind the near plane
+void transform_and_project_keep(const Camera *cam, Vec3 *points, int nb_points, int (*projected)[2]);
+// Whether cam only differs from base by its scale and a move across the
+// view: the W of every point is the same
+bool camera_same_view(const Camera *cam, const Camera *base);
+// Projection with cam of the points kept by transform_and_project_keep with
+// base, a scale and a shift by 1 / W per point (see camera_same_view)
+void project_kept(const Camera *cam, const Camera *base, const Vec3 *kept, int nb_points, int (*projected)[2]);
+void camera_fixed_view(const Camera *cam, Vec3 quant_center, Vec3 quant_scale, FixedView *fv);
+// points are nb_points x int16[3], little-endian, not necessarily aligned
+void transform_and_project_fixed(const FixedView *fv, const uint8_t *points, int nb_points, int (*projected)[2]);
+
+static inline int camera_screen_coord(float v) {
+  if (v > SCREEN_COORD_LIMIT) return SCREEN_COORD_LIMIT;
+  if (v < -SCREEN_COORD_LIMIT) return -SCREEN_COORD_LIMIT;
+  return (int)v;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include "clip.h"
+#include <stdint.h>
+
+// a + (b - a) * num / den rounded to nearest, den > 0
+static int lerp(int a, int b, int64_t num, int64_t den) {
+  int64_t d = (int64_t)(b - a) * num;
+  d = d >= 0 ? (d + den / 2) / den : -((-d + den / 2) / den);
+  return a + (int)d;
+}
+
+bool clip_segment(int *p0, int *p1) {
+  int code0 = clip_outcode(p0[0], p0[1]);
+  int code1 = clip_outcode(p1[0], p1[1]);
+  while (true) {
+    if (!(code0 | code1)) return true;
+    if (code0 & code1) return false;
+
+    // Move the outside end onto the edge of the screen it crosses
+    int *p = code0 ? p0 : p1;
+    int *q = code0 ? p1 : p0;
+    int code = code0 ? code0 : code1;
+    int x, y;
+    if (code & CLIP_LEFT) {
+      x = 0;
+      y = lerp(p[1], q[1], 0 - p[0], q[0] - p[0]);
+    } else if (code & CLIP_RIGHT) {
+      x = WIDTH - 1;
+      y = lerp(p[1], q[1], p[0] - (WIDTH - 1), p[0] - q[0]);
+    } else if (code & CLIP_TOP) {
+      y = 0;
+      x = lerp(p[0], q[0], 0 - p[1], q[1] - p[1]);
+    } else {
+      y = HEIGHT - 1;
+      x = lerp(p[0], q[0], p[1] - (HEIGHT - 1), p[1] - q[1]);
+    }
+    p[0] = x;
+    p[1] = y;
+    if (p == p0) {
+      code0 = clip_outcode(x, y);
+    } else {
+      code1 = clip_outcode(x, y);
+    }
+  }
+}
+
+static void project(const float *c, int *p) {
+  p[0] = camera_screen_coord(c[0] / c[2] + WIDTH / 2);
+  p[1] = camera_screen_coord(c[1] / c[2] + HEIGHT / 2);
+}
+
+bool clip_near(const float *c0, const float *c1, int *p0, int *p1) {
+  bool in0 = c0[2] >= CAMERA_NEAR, in1 = c1[2] >= CAMERA_NEAR;
+  if (!in0 && !in1) return false;
+
+  float c[3];
+  float t = (CAMERA_NEAR - c0[2]) / (c1[2] - c0[2]);
+  for (int i = 0; i < 3; i++) {
+    c[i] = c0[i] + (c1[i] - c0[i]) * t;
+  }
+  c[2] = CAMERA_NEAR;
+  project(in0 ? c0 : c, p0);
+  project(in1 ? c1 : c, p1);
+  return true;
+}
+
+int clip_near_triangle(const float (*c)[3], int (*p)[2], float *z) {
+  int n = 0;
+  for (int k = 0; k < 3; k++) {
+    const float *a = c[k], *b = c[k == 2 ? 0 : k + 1];
+    bool in_a = a[2] >= CAMERA_NEAR, in_b = b[2] >= CAMERA_NEAR;
+    if (in_a) {
+      project(a, p[n]);
+      z[n++] = 1.0f / a[2];
+    }
+    if (in_a != in_b) {
+      // Where the side a-b crosses the near plane
+      float m[3];
+      float t = (CAMERA_NEAR - a[2]) / (b[2] - a[2]);
+      m[0] = a[0] + (b[0] - a[0]) * t;
+      m[1] = a[1] + (b[1] - a[1]) * t;
+      m[2] = CAMERA_NEAR;
+      project(m, p[n]);
+      z[n++] = 1.0f / CAMERA_NEAR;
+    }
+  }
+  return n;
+}
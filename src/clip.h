@@ -0,0 +1,31 @@
+#ifndef CLIP_H
+#define CLIP_H
+
+#include "camera.h"
+#include <stdbool.h>
+
+// Cohen-Sutherland outcodes against the screen
+#define CLIP_LEFT 1
+#define CLIP_RIGHT 2
+#define CLIP_TOP 4
+#define CLIP_BOTTOM 8
+
+static inline int clip_outcode(int x, int y) {
+  return (x < 0 ? CLIP_LEFT : (x >= WIDTH ? CLIP_RIGHT : 0)) |
+         (y < 0 ? CLIP_TOP : (y >= HEIGHT ? CLIP_BOTTOM : 0));
+}
+
+// Clips the segment to the screen, returns false when nothing is left.
+// Coordinates must stay within +-2^24 (see camera.h).
+bool clip_segment(int *p0, int *p1);
+
+// Clips a camera space segment (X, Y, W) to W >= CAMERA_NEAR and projects it,
+// returns false when both ends are behind the near plane.
+bool clip_near(const float *c0, const float *c1, int *p0, int *p1);
+
+// Clips a camera space triangle to W >= CAMERA_NEAR and projects what is
+// left, a polygon of up to 4 vertices with their 1/W. Returns its number of
+// vertices, 0 when the triangle is behind the near plane.
+int clip_near_triangle(const float (*c)[3], int (*p)[2], float *z);
+
+#endif
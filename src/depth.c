@@ -0,0 +1,86 @@
+#include "depth.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+DepthBuffer depth;
+
+bool depth_init() {
+  depth.texels = malloc(DEPTH_WIDTH * DEPTH_HEIGHT * sizeof(uint16_t));
+  return depth.texels != NULL;
+}
+
+void depth_free() {
+  free(depth.texels);
+  depth.texels = NULL;
+}
+
+void depth_clear() {
+  memset(depth.texels, 0, DEPTH_WIDTH * DEPTH_HEIGHT * sizeof(uint16_t));
+}
+
+void depth_triangle(const int *p0, const int *p1, const int *p2, float z0, float z1, float z2) {
+  // Doubled coordinates: the center of texel (i, j) is at (4i + 1, 4j + 1)
+  int64_t x[3] = {2 * (int64_t)p0[0], 2 * (int64_t)p1[0], 2 * (int64_t)p2[0]};
+  int64_t y[3] = {2 * (int64_t)p0[1], 2 * (int64_t)p1[1], 2 * (int64_t)p2[1]};
+  float z[3] = {z0, z1, z2};
+  int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+  if (area == 0) return;
+  if (area < 0) {
+    // Either winding, the nearest face wins anyway
+    int64_t t;
+    t = x[1]; x[1] = x[2]; x[2] = t;
+    t = y[1]; y[1] = y[2]; y[2] = t;
+    float tz = z[1]; z[1] = z[2]; z[2] = tz;
+    area = -area;
+  }
+
+  int64_t min_x = x[0], max_x = x[0], min_y = y[0], max_y = y[0];
+  for (int k = 1; k < 3; k++) {
+    if (x[k] < min_x) min_x = x[k];
+    if (x[k] > max_x) max_x = x[k];
+    if (y[k] < min_y) min_y = y[k];
+    if (y[k] > max_y) max_y = y[k];
+  }
+  int i0 = min_x <= 1 ? 0 : (int)((min_x - 1 + 3) / 4);
+  int j0 = min_y <= 1 ? 0 : (int)((min_y - 1 + 3) / 4);
+  int i1 = max_x < 1 ? -1 : (max_x - 1) / 4 >= DEPTH_WIDTH ? DEPTH_WIDTH - 1 : (int)((max_x - 1) / 4);
+  int j1 = max_y < 1 ? -1 : (max_y - 1) / 4 >= DEPTH_HEIGHT ? DEPTH_HEIGHT - 1 : (int)((max_y - 1) / 4);
+  if (i0 > i1 || j0 > j1) return;
+
+  // Edge functions of the edges facing each vertex, inside when all >= 0
+  int64_t w_row[3], dx[3], dy[3];
+  for (int k = 0; k < 3; k++) {
+    int a = (k + 1) % 3, b = (k + 2) % 3;
+    dx[k] = -(y[b] - y[a]) * 4;
+    dy[k] = (x[b] - x[a]) * 4;
+    w_row[k] = (x[b] - x[a]) * (4 * j0 + 1 - y[a]) - (y[b] - y[a]) * (4 * i0 + 1 - x[a]);
+  }
+  float inv_area = 1.0f / (float)area;
+  // The texel keeps the farthest depth of the plane over its pixels, so that
+  // the lines on steep faces are not hidden by the face itself
+  float slope_x = 0.0f, slope_y = 0.0f;
+  for (int k = 0; k < 3; k++) {
+    slope_x += z[k] * (float)dx[k];
+    slope_y += z[k] * (float)dy[k];
+  }
+  float slack = (fabsf(slope_x) + fabsf(slope_y)) * inv_area * 0.5f;
+
+  for (int j = j0; j <= j1; j++) {
+    int64_t w0 = w_row[0], w1 = w_row[1], w2 = w_row[2];
+    uint16_t *row = depth.texels + j * DEPTH_WIDTH;
+    for (int i = i0; i <= i1; i++) {
+      if ((w0 | w1 | w2) >= 0) {
+        float zc = ((float)w0 * z[0] + (float)w1 * z[1] + (float)w2 * z[2]) * inv_area - slack;
+        int d = depth_value(zc > 0.0f ? zc : 0.0f);
+        if (d > row[i]) row[i] = d;
+      }
+      w0 += dx[0];
+      w1 += dx[1];
+      w2 += dx[2];
+    }
+    w_row[0] += dy[0];
+    w_row[1] += dy[1];
+    w_row[2] += dy[2];
+  }
+}
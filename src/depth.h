@@ -0,0 +1,48 @@
+#ifndef DEPTH_H
+#define DEPTH_H
+
+#include "camera.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Depth buffer of the hidden line mode, one texel per 2x2 pixels, 0 when
+// empty. Depths are 1/W (bigger is nearer) stored as the top bits of its
+// float encoding, which sort like the floats: 4 bits of exponent for W
+// from 1/16 to 4096, 12 bits of mantissa for a precision of 2^-12 of the
+// distance whatever the distance.
+#define DEPTH_WIDTH (WIDTH / 2)
+#define DEPTH_HEIGHT (HEIGHT / 2)
+#define DEPTH_MAX 65535
+// Bits of the float 2^-12, the smallest 1/W
+#define DEPTH_ZERO ((127 - 12) << 12)
+// Line pixels up to 2% farther than the faces are still drawn, they lie on
+// the faces they border
+#define DEPTH_BIAS 80
+
+typedef struct {
+  uint16_t *texels;     // DEPTH_WIDTH * DEPTH_HEIGHT
+} DepthBuffer;
+
+extern DepthBuffer depth;
+
+bool depth_init();
+void depth_free();
+void depth_clear();
+// Triangle of screen points with their 1/W, any size, ends in front of the
+// near plane
+void depth_triangle(const int *p0, const int *p1, const int *p2, float z0, float z1, float z2);
+
+static inline int depth_value(float inv_w) {
+  uint32_t bits;
+  memcpy(&bits, &inv_w, sizeof(bits));
+  int z = (int)(bits >> 11) - DEPTH_ZERO;
+  return z < 1 ? 1 : (z > DEPTH_MAX ? DEPTH_MAX : z);
+}
+
+// Whether the pixel (on screen) at depth z is in front of the faces
+static inline bool depth_visible(int x, int y, int z) {
+  return z + DEPTH_BIAS >= depth.texels[(y >> 1) * DEPTH_WIDTH + (x >> 1)];
+}
+
+#endif
@@ -0,0 +1,79 @@
+#include "fill.h"
+#include "depth.h"
+#include "framebuffer.h"
+#include <string.h>
+
+static int band_y0, band_y1;
+
+void fill_band(int y0) {
+  band_y0 = y0;
+  band_y1 = y0 + fb.strip_rows - 1;
+  if (band_y1 > FB_HEIGHT - 1) band_y1 = FB_HEIGHT - 1;
+  memset(fb.strip, 0, FB_WIDTH * fb.strip_rows * sizeof(uint16_t));
+}
+
+void fill_triangle(const int *p0, const int *p1, const int *p2, float z0, float z1, float z2, uint8_t ink) {
+  int64_t x[3] = {p0[0], p1[0], p2[0]};
+  int64_t y[3] = {p0[1], p1[1], p2[1]};
+  float z[3] = {z0, z1, z2};
+
+  int64_t min_x = x[0], max_x = x[0], min_y = y[0], max_y = y[0];
+  for (int k = 1; k < 3; k++) {
+    if (x[k] < min_x) min_x = x[k];
+    if (x[k] > max_x) max_x = x[k];
+    if (y[k] < min_y) min_y = y[k];
+    if (y[k] > max_y) max_y = y[k];
+  }
+  int x0 = min_x < 0 ? 0 : (int)min_x, x1 = max_x > FB_WIDTH - 1 ? FB_WIDTH - 1 : (int)max_x;
+  int y0 = min_y < band_y0 ? band_y0 : (int)min_y, y1 = max_y > band_y1 ? band_y1 : (int)max_y;
+  if (x0 > x1 || y0 > y1) return;
+
+  int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+  if (area == 0) return;
+  if (area < 0) {
+    // Either winding, the depth test sorts the faces out
+    int64_t t;
+    t = x[1]; x[1] = x[2]; x[2] = t;
+    t = y[1]; y[1] = y[2]; y[2] = t;
+    float tz = z[1]; z[1] = z[2]; z[2] = tz;
+    area = -area;
+  }
+
+  // Edge functions of the edges facing each vertex, inside when all >= 0,
+  // pixel centers are on integer coordinates like the lines
+  int64_t w_row[3], dx[3], dy[3];
+  float inv_area = 1.0f / (float)area;
+  float dz = 0.0f;
+  for (int k = 0; k < 3; k++) {
+    int a = (k + 1) % 3, b = (k + 2) % 3;
+    dx[k] = -(y[b] - y[a]);
+    dy[k] = x[b] - x[a];
+    w_row[k] = (x[b] - x[a]) * (y0 - y[a]) - (y[b] - y[a]) * (x0 - x[a]);
+    dz += z[k] * (float)dx[k];
+  }
+  dz *= inv_area;
+
+  uint16_t *band = (uint16_t *)fb.strip;
+  for (int py = y0; py <= y1; py++) {
+    int64_t w0 = w_row[0], w1 = w_row[1], w2 = w_row[2];
+    float pz = ((float)w0 * z[0] + (float)w1 * z[1] + (float)w2 * z[2]) * inv_area;
+    uint16_t *row = band + (py - band_y0) * FB_WIDTH;
+    for (int px = x0; px <= x1; px++) {
+      if ((w0 | w1 | w2) >= 0) {
+        int d = depth_value(pz > 0.0f ? pz : 0.0f);
+        if (d > row[px]) {
+          row[px] = d;
+          fb_plot(px, py, ink);
+        }
+      }
+      w0 += dx[0];
+      w1 += dx[1];
+      w2 += dx[2];
+      pz += dz;
+    }
+    w_row[0] += dy[0];
+    w_row[1] += dy[1];
+    w_row[2] += dy[2];
+  }
+  fb_touch(x0, y0, x1, y1);
+}
@@ -0,0 +1,18 @@
+#ifndef FILL_H
+#define FILL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Filled triangles into the framebuffer, one band of fb.strip_rows rows at
+// a time. The depth of the band's pixels is kept in fb.strip, which is
+// free until the flush, with the encoding of depth.h.
+
+// Starts a band, its depth is cleared
+void fill_band(int y0);
+// Fills the part of the triangle inside the band where it is nearer than
+// what the band already has. Screen points with their 1/W, any size, in
+// front of the near plane.
+void fill_triangle(const int *p0, const int *p1, const int *p2, float z0, float z1, float z2, uint8_t ink);
+
+#endif
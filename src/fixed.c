@@ -0,0 +1,12 @@
+#include "fixed.h"
+
+uint16_t fixed_recip_seed[256];
+
+void fixed_init() {
+  if (fixed_recip_seed[0]) return;
+  for (int i = 0; i < 256; i++) {
+    // 1 / m at the middle of [m, m + 1/512), Q15
+    float m = (256 + i + 0.5f) / 512.0f;
+    fixed_recip_seed[i] = (uint16_t)(32768.0f / m + 0.5f);
+  }
+}
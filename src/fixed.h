@@ -0,0 +1,34 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Reciprocal of u > 0 for the fixed point projection. Returns r and n such
+// that 1 / u ~= r * 2^(n - 62), with r a Q30 value in (1, 2]. One Newton
+// step from a 256 entry seed gives about 18 bits.
+extern uint16_t fixed_recip_seed[256];
+
+void fixed_init();
+
+static inline uint32_t fixed_recip(uint32_t u, int *n) {
+  int shift = __builtin_clz(u);
+  uint32_t m = u << shift;                                   // Q32 in [0.5, 1)
+  uint32_t r = (uint32_t)fixed_recip_seed[(m >> 23) & 0xFF] << 15;
+  uint32_t e = (uint32_t)(((uint64_t)m * r) >> 32);          // m * r, Q30 ~ 1
+  r = (uint32_t)(((uint64_t)r * ((1u << 31) - e)) >> 30);    // r * (2 - m * r)
+  *n = shift;
+  return r;
+}
+
+// r * 2^e as a float, built from its bits, for r > 0 and a result in the
+// normal range
+static inline float fixed_to_float(uint32_t r, int e) {
+  int shift = __builtin_clz(r);
+  uint32_t bits = (uint32_t)(127 + 31 - shift + e) << 23 | ((r << shift) >> 8 & 0x7FFFFF);
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+#endif
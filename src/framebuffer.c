@@ -0,0 +1,224 @@
+#include "framebuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+FrameBuffer fb;
+
+static eadk_color_t gray565(int level) {
+  return (eadk_color_t)(((level >> 3) << 11) | ((level >> 2) << 5) | (level >> 3));
+}
+
+bool fb_init() {
+  fb.pixels = malloc(FB_STRIDE * FB_HEIGHT);
+  if (!fb.pixels) return false;
+
+  // Biggest strip that fits, the rest of the heap is for the model batches
+  for (fb.strip_rows = FB_MAX_STRIP_ROWS; fb.strip_rows > 0; fb.strip_rows /= 2) {
+    fb.strip = malloc(FB_WIDTH * fb.strip_rows * sizeof(eadk_color_t));
+    if (fb.strip) break;
+  }
+  if (!fb.strip) {
+    free(fb.pixels);
+    fb.pixels = NULL;
+    return false;
+  }
+
+  eadk_color_t palette[16];
+  for (int i = 0; i < 16; i++) {
+    palette[i] = gray565(255 - i * 17);
+  }
+  fb_set_palette(palette);
+  memset(fb.pixels, FB_PAPER | (FB_PAPER << 4), FB_STRIDE * FB_HEIGHT);
+  for (int b = 0; b < FB_BANDS; b++) {
+    fb.shown[b] = fb.drawn[b] = (FbSpan){FB_WIDTH, -1};
+  }
+  fb.full_flush = true;
+  return true;
+}
+
+void fb_free() {
+  free(fb.pixels);
+  free(fb.strip);
+  fb.pixels = NULL;
+  fb.strip = NULL;
+}
+
+void fb_set_palette(const eadk_color_t palette[16]) {
+  memcpy(fb.palette, palette, sizeof(fb.palette));
+  for (int b = 0; b < 256; b++) {
+    fb.pair_lut[b] = (uint32_t)palette[b & 0x0F] | ((uint32_t)palette[b >> 4] << 16);
+  }
+}
+
+void fb_clear() {
+  for (int b = 0; b < FB_BANDS; b++) {
+    FbSpan span = fb.shown[b];
+    if (span.x1 >= span.x0) {
+      int x0 = span.x0 >> 1, bytes = (span.x1 >> 1) - x0 + 1;
+      for (int y = b * FB_BAND_ROWS; y < (b + 1) * FB_BAND_ROWS; y++) {
+        memset(fb.pixels + y * FB_STRIDE + x0, FB_PAPER | (FB_PAPER << 4), bytes);
+      }
+    }
+    fb.drawn[b] = (FbSpan){FB_WIDTH, -1};
+  }
+}
+
+static void add_box(FbSpan *spans, int x0, int y0, int x1, int y1) {
+  for (int b = y0 / FB_BAND_ROWS; b <= y1 / FB_BAND_ROWS; b++) {
+    if (x0 < spans[b].x0) spans[b].x0 = x0;
+    if (x1 > spans[b].x1) spans[b].x1 = x1;
+  }
+}
+
+void fb_touch(int x0, int y0, int x1, int y1) {
+  add_box(fb.drawn, x0, y0, x1, y1);
+}
+
+// Pixel x of the row, without a branch on the nibble
+static inline void plot_row(uint8_t *row, int x, uint8_t ink) {
+  uint8_t *p = row + (x >> 1);
+  int shift = (x & 1) << 2;
+  *p = (*p & ~(0x0F << shift)) | (ink << shift);
+}
+
+// Two pixels of a line, each unless it is already darker. The second one
+// is skipped without ink, it may be off screen then. Forced inline, -Os
+// would call it twice per pixel.
+static inline __attribute__((always_inline)) void blend_pair(uint8_t *p0, int shift0, uint8_t ink0, uint8_t *p1, int shift1, uint8_t ink1) {
+  if (ink0 > ((*p0 >> shift0) & 0x0F)) *p0 = (*p0 & ~(0x0F << shift0)) | (ink0 << shift0);
+  if (ink1 > 0 && ink1 > ((*p1 >> shift1) & 0x0F)) *p1 = (*p1 & ~(0x0F << shift1)) | (ink1 << shift1);
+}
+
+// Pixels x0 to x1 of the row, whole bytes at once
+static void fill_row(uint8_t *row, int x0, int x1, uint8_t ink) {
+  if (x0 & 1) {
+    row[x0 >> 1] = (row[x0 >> 1] & 0x0F) | (ink << 4);
+    x0++;
+  }
+  if (!(x1 & 1)) {
+    row[x1 >> 1] = (row[x1 >> 1] & 0xF0) | ink;
+    x1--;
+  }
+  if (x1 > x0) memset(row + (x0 >> 1), ink | (ink << 4), (x1 - x0 + 1) >> 1);
+}
+
+// Horizontal lines are filled a byte at a time, the others walk the row
+// pointer instead of multiplying y
+void fb_draw_line(int x0, int y0, int x1, int y1, uint8_t ink) {
+  fb_touch(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0);
+  uint8_t *row = fb.pixels + y0 * FB_STRIDE;
+  if (y0 == y1) {
+    fill_row(row, x0 < x1 ? x0 : x1, x0 < x1 ? x1 : x0, ink);
+    return;
+  }
+  const uint8_t *last = fb.pixels + y1 * FB_STRIDE;
+  int dx = abs(x1 - x0), dy = abs(y1 - y0);
+  int sx = x0 < x1 ? 1 : -1, step = y0 < y1 ? FB_STRIDE : -FB_STRIDE;
+  int err = dx - dy;
+  while (true) {
+    plot_row(row, x0, ink);
+    if (x0 == x1 && row == last) break;
+    int e2 = 2 * err;
+    if (e2 > -dy) { err -= dy; x0 += sx; }
+    if (e2 < dx) { err += dx; row += step; }
+  }
+}
+
+// Xiaolin Wu's line: along the major axis, the two pixels across the exact
+// line share the ink by their distance to it, in 16.16 fixed point. The
+// second pixel has ink only inside the ends' box, so no bounds check.
+void fb_draw_line_aa(int x0, int y0, int x1, int y1, uint8_t ink) {
+  fb_touch(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0);
+  // Ink of a pixel covered c / 16, kept for the next lines of the same ink
+  static uint8_t level[17], level_ink;
+  if (ink != level_ink) {
+    for (int c = 0; c <= 16; c++) level[c] = (c * ink + 8) >> 4;
+    level_ink = ink;
+  }
+
+  int dx = x1 - x0, dy = y1 - y0;
+  if (abs(dx) >= abs(dy)) {
+    if (dx < 0) {
+      int t;
+      t = x0; x0 = x1; x1 = t;
+      t = y0; y0 = y1; y1 = t;
+      dx = -dx;
+      dy = -dy;
+    }
+    int32_t y = y0 << 16, gradient = dx ? (int32_t)(((int64_t)dy << 16) / dx) : 0;
+    for (int x = x0; x <= x1; x++, y += gradient) {
+      uint8_t *p = fb.pixels + (y >> 16) * FB_STRIDE + (x >> 1);
+      int f = (y >> 12) & 15, shift = (x & 1) << 2;
+      blend_pair(p, shift, level[16 - f], p + FB_STRIDE, shift, level[f]);
+    }
+  } else {
+    if (dy < 0) {
+      int t;
+      t = x0; x0 = x1; x1 = t;
+      t = y0; y0 = y1; y1 = t;
+      dx = -dx;
+      dy = -dy;
+    }
+    int32_t x = x0 << 16, gradient = (int32_t)(((int64_t)dx << 16) / dy);
+    uint8_t *row = fb.pixels + y0 * FB_STRIDE;
+    for (int y = y0; y <= y1; y++, x += gradient, row += FB_STRIDE) {
+      int i = x >> 16, f = (x >> 12) & 15, shift = (i & 1) << 2;
+      blend_pair(row + (i >> 1), shift, level[16 - f], row + ((i + 1) >> 1), shift ^ 4, level[f]);
+    }
+  }
+}
+
+void fb_flush() {
+  fb.pushed_pixels = 0;
+  fb.push_calls = 0;
+  for (int y = 0; y < FB_HEIGHT; y += fb.strip_rows) {
+    int rows = (y + fb.strip_rows <= FB_HEIGHT) ? fb.strip_rows : FB_HEIGHT - y;
+
+    // Union of the old and new coverage of the bands under the strip
+    int x0 = 0, x1 = FB_WIDTH - 1, y0 = y, y1 = y + rows - 1;
+    if (!fb.full_flush) {
+      x0 = FB_WIDTH;
+      x1 = -1;
+      y0 = FB_HEIGHT;
+      y1 = -1;
+      for (int b = y / FB_BAND_ROWS; b <= (y + rows - 1) / FB_BAND_ROWS; b++) {
+        FbSpan s = fb.shown[b], d = fb.drawn[b];
+        if (d.x0 < s.x0) s.x0 = d.x0;
+        if (d.x1 > s.x1) s.x1 = d.x1;
+        if (s.x1 < s.x0) continue;
+        if (s.x0 < x0) x0 = s.x0;
+        if (s.x1 > x1) x1 = s.x1;
+        if (b * FB_BAND_ROWS < y0) y0 = b * FB_BAND_ROWS;
+        y1 = (b + 1) * FB_BAND_ROWS - 1;
+      }
+      if (x1 < x0) continue;
+      if (y0 < y) y0 = y;
+      if (y1 > y + rows - 1) y1 = y + rows - 1;
+    }
+
+    // Whole bytes, two pixels each
+    int bx0 = x0 >> 1, bytes = (x1 >> 1) - bx0 + 1;
+    uint8_t *dst = (uint8_t *)fb.strip;
+    for (int row = y0; row <= y1; row++) {
+      const uint8_t *src = fb.pixels + row * FB_STRIDE + bx0;
+      for (int i = 0; i < bytes; i++) {
+        memcpy(dst, &fb.pair_lut[src[i]], 4);
+        dst += 4;
+      }
+    }
+    eadk_display_push_rect((eadk_rect_t){bx0 * 2, y0, bytes * 2, y1 - y0 + 1}, fb.strip);
+    fb.pushed_pixels += bytes * 2 * (y1 - y0 + 1);
+    fb.push_calls++;
+  }
+
+  memcpy(fb.shown, fb.drawn, sizeof(fb.shown));
+  fb.full_flush = false;
+}
+
+void fb_invalidate() {
+  fb.full_flush = true;
+}
+
+void fb_overdrawn(int x0, int y0, int x1, int y1) {
+  add_box(fb.shown, x0, y0, x1, y1);
+}
@@ -0,0 +1,71 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include "eadk.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FB_WIDTH EADK_SCREEN_WIDTH
+#define FB_HEIGHT EADK_SCREEN_HEIGHT
+// 4 bits per pixel, two pixels per byte (low nibble = even x)
+#define FB_STRIDE (FB_WIDTH / 2)
+
+// Palette indices, the default palette is a gray ramp from white (0) to black (15)
+#define FB_PAPER 0
+#define FB_INK 15
+
+#define FB_MAX_STRIP_ROWS 24
+
+// Coverage is tracked as one x span per band of rows: only what the last
+// frame drew is cleared, and only what it or this frame drew is pushed.
+#define FB_BAND_ROWS 8
+#define FB_BANDS (FB_HEIGHT / FB_BAND_ROWS)
+
+typedef struct {
+  int16_t x0, x1;            // empty when x1 < x0
+} FbSpan;
+
+typedef struct {
+  uint8_t *pixels;           // FB_STRIDE * FB_HEIGHT bytes
+  eadk_color_t *strip;       // FB_WIDTH * strip_rows RGB565 pixels
+  int strip_rows;
+  eadk_color_t palette[16];
+  uint32_t pair_lut[256];    // one byte of pixels -> two RGB565 pixels
+  FbSpan shown[FB_BANDS];    // on screen, from the last flush
+  FbSpan drawn[FB_BANDS];    // drawn since the last clear
+  bool full_flush;           // the screen was drawn over by someone else
+  uint32_t pushed_pixels;    // by the last flush
+  uint32_t push_calls;
+} FrameBuffer;
+
+extern FrameBuffer fb;
+
+bool fb_init();
+void fb_free();
+void fb_set_palette(const eadk_color_t palette[16]);
+// Clears what the last frame drew
+void fb_clear();
+// Marks the box as drawn, for the next flush
+void fb_touch(int x0, int y0, int x1, int y1);
+// Both ends must be on screen (see clip.h)
+void fb_draw_line(int x0, int y0, int x1, int y1, uint8_t ink);
+// Anti-aliased, the pixels keep the darker of their ink and the line's.
+// Both ends must be on screen.
+void fb_draw_line_aa(int x0, int y0, int x1, int y1, uint8_t ink);
+// Pushes the touched parts of the framebuffer to the screen
+void fb_flush();
+// Next flush pushes the whole screen
+void fb_invalidate();
+// The box was drawn over on screen, the next flush repaints it
+void fb_overdrawn(int x0, int y0, int x1, int y1);
+
+static inline void fb_plot(int x, int y, uint8_t ink) {
+  uint8_t *p = fb.pixels + y * FB_STRIDE + (x >> 1);
+  if (x & 1) {
+    *p = (*p & 0x0F) | (ink << 4);
+  } else {
+    *p = (*p & 0xF0) | ink;
+  }
+}
+
+#endif
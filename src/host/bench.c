@@ -0,0 +1,105 @@
+// Headless benchmark of the app: runs main.c against the host eadk stub on
+// each model, with a scripted auto camera orbit, and prints frames per
+// second, display traffic and peak heap for both rasters, and for the strip
+// raster in hidden line, filled and anti-aliased modes, and zoomed in 7x.
+//
+// Usage: bench [-p] model.bin...
+// -p turns the profiler on (key var) and prints its table after each row,
+// over the last frames of the orbit.
+
+#define _POSIX_C_SOURCE 199309L
+#include "eadk_host.h"
+#include "../profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ORBIT_FRAMES 300
+
+// Key held before the orbit for each row, and for how many frames
+static const struct {
+  const char *name;
+  eadk_keyboard_state_t key;
+  int frames;
+} variants[] = {
+  {"strip", 0, 1},
+  {"pixel", HOST_KEY(eadk_key_xnt), 1},
+  {"hidden", HOST_KEY(eadk_key_three), 1},
+  {"filled", HOST_KEY(eadk_key_four), 1},
+  {"aa", HOST_KEY(eadk_key_five), 1},
+  {"zoom", HOST_KEY(eadk_key_ok), 40},
+};
+
+int viewer_main();
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static unsigned char *load(const char *path, size_t *size) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  *size = ftell(f);
+  rewind(f);
+  unsigned char *data = malloc(*size);
+  if (data && fread(data, 1, *size, f) != *size) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  return data;
+}
+
+int main(int argc, char **argv) {
+  bool profile = argc > 1 && strcmp(argv[1], "-p") == 0;
+  printf("%-20s %-6s %7s %9s %11s %11s %10s\n", "model", "raster", "frames", "fps", "px/frame", "calls/frame", "peak heap");
+
+  for (int arg = profile ? 2 : 1; arg < argc; arg++) {
+    size_t size;
+    unsigned char *data = load(argv[arg], &size);
+    if (!data) {
+      fprintf(stderr, "%s: cannot read\n", argv[arg]);
+      continue;
+    }
+    host_set_external_data(data, size);
+    const char *name = strrchr(argv[arg], '/') ? strrchr(argv[arg], '/') + 1 : argv[arg];
+
+    for (size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+      // Startup menu timeout, the key of the variant, var for the profiler,
+      // then 0 for the auto camera orbit
+      HostKeyStep script[] = {
+        {10, 0},
+        {variants[v].frames, variants[v].key},
+        {1, 0},
+        {profile, HOST_KEY(eadk_key_var)},
+        {profile, 0},
+        {1, HOST_KEY(eadk_key_zero)},
+        {ORBIT_FRAMES, 0},
+      };
+      host_set_keys(script, sizeof(script) / sizeof(script[0]));
+      host_reset_stats();
+
+      double start = now();
+      viewer_main();
+      double seconds = now() - start;
+
+      // Each main loop iteration in auto camera mode renders one frame
+      printf("%-20s %-6s %7d %9.1f %11llu %11llu %10zu\n", name, variants[v].name, ORBIT_FRAMES,
+             ORBIT_FRAMES / seconds,
+             (unsigned long long)(host_stats.push_pixels / ORBIT_FRAMES),
+             (unsigned long long)(host_stats.push_calls / ORBIT_FRAMES),
+             host_stats.heap_peak);
+      if (profile) {
+        char table[512];
+        profile_format(table, sizeof(table));
+        printf("%s\n\n", table);
+      }
+    }
+    free(data);
+  }
+  return 0;
+}
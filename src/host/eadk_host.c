@@ -0,0 +1,218 @@
+#define _POSIX_C_SOURCE 199309L
+#include "eadk_host.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+const char *eadk_external_data;
+size_t eadk_external_data_size;
+
+eadk_color_t host_screen[EADK_SCREEN_HEIGHT][EADK_SCREEN_WIDTH];
+HostStats host_stats;
+
+static const HostKeyStep *key_script;
+static int key_steps, key_step, key_step_scans;
+static uint64_t fake_millis;
+
+void host_set_keys(const HostKeyStep *script, int nb_steps) {
+  key_script = script;
+  key_steps = nb_steps;
+  key_step = 0;
+  key_step_scans = 0;
+}
+
+void host_set_external_data(const void *data, size_t size) {
+  eadk_external_data = data;
+  eadk_external_data_size = size;
+}
+
+// Blocks of an older generation were forgotten by host_reset_stats
+static unsigned heap_generation;
+
+void host_reset_stats() {
+  memset(&host_stats, 0, sizeof(host_stats));
+  heap_generation++;
+}
+
+// Heap
+
+// Keeps the allocations aligned like malloc does
+typedef union {
+  struct {
+    size_t size;
+    unsigned generation;
+  } block;
+  long double align_ld;
+  long long align_ll;
+  void *align_p;
+} AllocHeader;
+
+void *host_malloc(size_t size) {
+  if (size > HOST_HEAP_SIZE - host_stats.heap_used) return NULL;
+  AllocHeader *h = malloc(sizeof(AllocHeader) + size);
+  if (!h) return NULL;
+  h->block.size = size;
+  h->block.generation = heap_generation;
+  host_stats.heap_used += size;
+  if (host_stats.heap_used > host_stats.heap_peak) host_stats.heap_peak = host_stats.heap_used;
+  return h + 1;
+}
+
+void *host_calloc(size_t count, size_t size) {
+  void *p = host_malloc(count * size);
+  if (p) memset(p, 0, count * size);
+  return p;
+}
+
+void host_free(void *p) {
+  if (!p) return;
+  AllocHeader *h = (AllocHeader *)p - 1;
+  if (h->block.generation == heap_generation) host_stats.heap_used -= h->block.size;
+  free(h);
+}
+
+void *host_realloc(void *p, size_t size) {
+  void *q = host_malloc(size);
+  if (q && p) {
+    size_t old = ((AllocHeader *)p - 1)->block.size;
+    memcpy(q, p, old < size ? old : size);
+    host_free(p);
+  }
+  return q;
+}
+
+// Display
+
+static bool clip_rect(eadk_rect_t *r) {
+  if (r->x >= EADK_SCREEN_WIDTH || r->y >= EADK_SCREEN_HEIGHT) return false;
+  if (r->x + r->width > EADK_SCREEN_WIDTH) r->width = EADK_SCREEN_WIDTH - r->x;
+  if (r->y + r->height > EADK_SCREEN_HEIGHT) r->height = EADK_SCREEN_HEIGHT - r->y;
+  return r->width > 0 && r->height > 0;
+}
+
+void eadk_display_push_rect(eadk_rect_t rect, const eadk_color_t *pixels) {
+  host_stats.push_calls++;
+  host_stats.push_pixels += rect.width * rect.height;
+  int stride = rect.width;
+  if (!clip_rect(&rect)) return;
+  for (int y = 0; y < rect.height; y++) {
+    memcpy(&host_screen[rect.y + y][rect.x], pixels + y * stride, rect.width * sizeof(eadk_color_t));
+  }
+}
+
+static void fill_rect(eadk_rect_t rect, eadk_color_t color) {
+  host_stats.push_pixels += rect.width * rect.height;
+  if (!clip_rect(&rect)) return;
+  for (int y = 0; y < rect.height; y++) {
+    for (int x = 0; x < rect.width; x++) {
+      host_screen[rect.y + y][rect.x + x] = color;
+    }
+  }
+}
+
+void eadk_display_push_rect_uniform(eadk_rect_t rect, eadk_color_t color) {
+  host_stats.push_calls++;
+  fill_rect(rect, color);
+}
+
+void eadk_display_pull_rect(eadk_rect_t rect, eadk_color_t *pixels) {
+  int stride = rect.width;
+  if (!clip_rect(&rect)) return;
+  for (int y = 0; y < rect.height; y++) {
+    memcpy(pixels + y * stride, &host_screen[rect.y + y][rect.x], rect.width * sizeof(eadk_color_t));
+  }
+}
+
+bool eadk_display_wait_for_vblank() {
+  return true;
+}
+
+// No glyphs, text is drawn as its background box
+void eadk_display_draw_string(const char *text, eadk_point_t point, bool large_font, eadk_color_t text_color, eadk_color_t background_color) {
+  int char_width = large_font ? 10 : 7, line_height = large_font ? 18 : 14;
+  int x = point.x, y = point.y;
+  host_stats.push_calls++;
+  for (const char *c = text; *c; c++) {
+    if (*c == '\n') {
+      x = point.x;
+      y += line_height;
+      continue;
+    }
+    fill_rect((eadk_rect_t){x, y, char_width, line_height}, background_color);
+    x += char_width;
+  }
+}
+
+// Keyboard
+
+eadk_keyboard_state_t eadk_keyboard_scan() {
+  host_stats.scans++;
+  while (key_step < key_steps && key_step_scans >= key_script[key_step].scans) {
+    key_step++;
+    key_step_scans = 0;
+  }
+  if (key_step < key_steps) {
+    key_step_scans++;
+    return key_script[key_step].keys;
+  }
+  // Alternate with no key so that "wait for release" loops end too
+  return (key_step_scans++ & 1) ? 0 : HOST_KEY(eadk_key_home);
+}
+
+eadk_event_t eadk_event_get(int32_t *timeout) {
+  return eadk_keyboard_key_down(eadk_keyboard_scan(), eadk_key_home) ? eadk_event_back : eadk_event_ok;
+}
+
+// Timing
+
+void eadk_timing_usleep(uint32_t us) {
+  fake_millis += us / 1000;
+}
+
+void eadk_timing_msleep(uint32_t ms) {
+  fake_millis += ms;
+}
+
+uint64_t eadk_timing_millis() {
+  uint64_t now = fake_millis;
+  fake_millis += HOST_TICK_MS;
+  return now;
+}
+
+uint64_t host_clock_us() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+// Misc
+
+void eadk_backlight_set_brightness(uint8_t brightness) {}
+
+uint8_t eadk_backlight_brightness() {
+  return 255;
+}
+
+bool eadk_battery_is_charging() {
+  return false;
+}
+
+uint8_t eadk_battery_level() {
+  return 100;
+}
+
+float eadk_battery_voltage() {
+  return 4.0f;
+}
+
+bool eadk_usb_is_plugged() {
+  return true;
+}
+
+uint32_t eadk_random() {
+  static uint32_t state = 2463534242u;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
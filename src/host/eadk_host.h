@@ -0,0 +1,43 @@
+#ifndef EADK_HOST_H
+#define EADK_HOST_H
+
+// Host implementation of eadk.h to run the app on a dev machine: software
+// screen, counted display calls, scripted keyboard and a fake clock.
+
+#include "../eadk.h"
+
+typedef struct {
+  uint64_t push_calls;       // push_rect, push_rect_uniform and draw_string
+  uint64_t push_pixels;
+  uint64_t scans;            // keyboard scans
+  size_t heap_used;
+  size_t heap_peak;
+} HostStats;
+
+// keys are held down for scans keyboard scans
+typedef struct {
+  int scans;
+  eadk_keyboard_state_t keys;
+} HostKeyStep;
+
+// Assumed heap of an app on the device, small enough for the big samples
+// to need several batches. host_malloc fails past it.
+#ifndef HOST_HEAP_SIZE
+#define HOST_HEAP_SIZE (128 * 1024)
+#endif
+
+// Every clock read advances the fake clock by this much, msleep by its duration
+#define HOST_TICK_MS 30
+
+extern eadk_color_t host_screen[EADK_SCREEN_HEIGHT][EADK_SCREEN_WIDTH];
+extern HostStats host_stats;
+
+// Once the script is over, home is pressed every other scan until the app quits
+void host_set_keys(const HostKeyStep *script, int nb_steps);
+void host_set_external_data(const void *data, size_t size);
+// Also forgets the allocations, like the device does when the app quits
+void host_reset_stats();
+
+#define HOST_KEY(key) ((eadk_keyboard_state_t)1 << (key))
+
+#endif
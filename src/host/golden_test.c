@@ -0,0 +1,428 @@
+// Golden image tests of the renderer: renders camera poses over each model
+// with both rasters, incrementally, and compares the screen of the host
+// stub with reference PPM images. A pixel that differs is tolerated when
+// both images have its color in a 3x3 neighborhood; a case fails when more
+// than GOLDEN_MAX_BAD per mille of its pixels are not.
+//
+// Usage: golden_test [--update] refdir outdir model.bin...
+// --update rewrites the references, failing cases are written to outdir.
+// Bundles of the same models are checked against their references.
+
+#include "eadk_host.h"
+#include "../camera.h"
+#include "../framebuffer.h"
+#include "../mesh.h"
+#include "../render.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Per mille of the drawn pixels. The references come from the float path,
+// fixed point projections may be a pixel or two off.
+#if FIXED_POINT
+#define GOLDEN_MAX_BAD 25
+#else
+#define GOLDEN_MAX_BAD 1
+#endif
+
+typedef eadk_color_t Image[EADK_SCREEN_HEIGHT][EADK_SCREEN_WIDTH];
+
+typedef struct {
+  const char *name;
+  float theta, phi, dist, scale;
+  float fly_t;   // >= 0 for a fly-through pose
+} Pose;
+
+static const Pose poses[] = {
+  {"front", 0.0f, 0.0f, 10.0f, 50.0f, -1.0f},
+  {"orbit", 0.7f, 0.3f, 10.0f, 50.0f, -1.0f},
+  {"zoom", 2.5f, -0.6f, 6.0f, 300.0f, -1.0f},
+  {"inside", 0.0f, 0.0f, 0.0f, 50.0f, 0.5f},
+};
+
+#define NB_POSES (int)(sizeof(poses) / sizeof(poses[0]))
+
+static unsigned char *load(const char *path, size_t *size) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  *size = ftell(f);
+  rewind(f);
+  unsigned char *data = malloc(*size);
+  if (data && fread(data, 1, *size, f) != *size) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  return data;
+}
+
+static bool write_ppm(const char *path, Image image) {
+  FILE *f = fopen(path, "wb");
+  if (!f) return false;
+  fprintf(f, "P6\n%d %d\n255\n", EADK_SCREEN_WIDTH, EADK_SCREEN_HEIGHT);
+  for (int y = 0; y < EADK_SCREEN_HEIGHT; y++) {
+    for (int x = 0; x < EADK_SCREEN_WIDTH; x++) {
+      eadk_color_t c = image[y][x];
+      int r = c >> 11, g = (c >> 5) & 0x3F, b = c & 0x1F;
+      unsigned char rgb[3] = {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+  return fclose(f) == 0;
+}
+
+static bool read_ppm(const char *path, Image image) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  int width, height, max;
+  bool ok = fscanf(f, "P6 %d %d %d", &width, &height, &max) == 3 && fgetc(f) != EOF &&
+            width == EADK_SCREEN_WIDTH && height == EADK_SCREEN_HEIGHT && max == 255;
+  for (int y = 0; ok && y < EADK_SCREEN_HEIGHT; y++) {
+    for (int x = 0; ok && x < EADK_SCREEN_WIDTH; x++) {
+      unsigned char rgb[3];
+      ok = fread(rgb, 1, 3, f) == 3;
+      image[y][x] = ((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3);
+    }
+  }
+  fclose(f);
+  return ok;
+}
+
+static bool near_color(Image image, int x, int y, eadk_color_t color) {
+  for (int j = y - 1; j <= y + 1; j++) {
+    for (int i = x - 1; i <= x + 1; i++) {
+      if (i >= 0 && i < EADK_SCREEN_WIDTH && j >= 0 && j < EADK_SCREEN_HEIGHT && image[j][i] == color) return true;
+    }
+  }
+  return false;
+}
+
+// Returns the number of pixels out of tolerance, drawn is the number of
+// non white pixels of the reference
+static int compare(Image out, Image ref, int *drawn) {
+  int bad = 0;
+  *drawn = 0;
+  for (int y = 0; y < EADK_SCREEN_HEIGHT; y++) {
+    for (int x = 0; x < EADK_SCREEN_WIDTH; x++) {
+      *drawn += ref[y][x] != eadk_color_white;
+      if (out[y][x] != ref[y][x] && !(near_color(ref, x, y, out[y][x]) && near_color(out, x, y, ref[y][x]))) {
+        bad++;
+      }
+    }
+  }
+  return bad;
+}
+
+// Orbit poses look at the center of the bounding box
+static void pose_camera(const Pose *pose, const Mesh *mesh, Camera *cam) {
+  Vec3 bbox_min, bbox_max;
+  mesh_bounds(mesh, &bbox_min, &bbox_max);
+  if (pose->fly_t >= 0.0f) {
+    camera_fly_through(cam, pose->fly_t, bbox_min, bbox_max, pose->scale);
+  } else {
+    camera_update(cam, pose->theta, pose->phi, pose->dist, pose->scale,
+                  0.5f * (bbox_min.x + bbox_max.x), 0.5f * (bbox_min.y + bbox_max.y), 0.5f * (bbox_min.z + bbox_max.z));
+  }
+}
+
+static int polls;
+
+static bool go_on() {
+  polls++;
+  return false;
+}
+
+static bool stop() {
+  polls++;
+  return true;
+}
+
+static const char *ref_dir, *out_dir;
+static bool update;
+static int cases;
+
+// Compares the screen with the reference of the case, or writes it when
+// updating, returns 1 on failure
+static int check(const char *model, const char *name, bool pixel) {
+  static Image ref;
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s-%s.ppm", ref_dir, model, name);
+  if (update) {
+    // Both rasters draw the same image
+    if (pixel || write_ppm(path, host_screen)) return 0;
+    fprintf(stderr, "%s: cannot write\n", path);
+    return 1;
+  }
+
+  cases++;
+  int drawn, bad = -1;
+  if (read_ppm(path, ref)) {
+    bad = compare(host_screen, ref, &drawn);
+  }
+  if (bad >= 0 && bad * 1000 <= drawn * GOLDEN_MAX_BAD) return 0;
+
+  snprintf(path, sizeof(path), "%s/%s-%s-%s.ppm", out_dir, model, name, pixel ? "pixel" : "strip");
+  write_ppm(path, host_screen);
+  if (bad < 0) {
+    printf("FAIL %s %s %s: no reference\n", model, name, pixel ? "pixel" : "strip");
+  } else {
+    printf("FAIL %s %s %s: %d of %d pixels off, see %s\n", model, name, pixel ? "pixel" : "strip", bad, drawn, path);
+  }
+  return 1;
+}
+
+// A copy of the model with one face index of the adjacency out of range,
+// then one triangle vertex, must not open
+static int check_bad_indices(const char *name, const unsigned char *model, size_t size) {
+  Mesh mesh;
+  if (!mesh_open(&mesh, model, size) || mesh.nb_faces == 0 || mesh.nb_triangles == 0 || mesh.nb_points >= 65536) return 0;
+  unsigned char *copy = malloc(size);
+  if (!copy) return 1;
+  int failures = 0;
+  const size_t offsets[2] = {mesh.adjacency - model, mesh.triangles - model};
+  const uint16_t bad[2] = {(uint16_t)mesh.nb_faces, (uint16_t)mesh.nb_points};
+  for (int k = 0; k < 2; k++) {
+    Mesh opened;
+    memcpy(copy, model, size);
+    memcpy(copy + offsets[k], &bad[k], sizeof(bad[k]));
+    cases++;
+    if (mesh_open(&opened, copy, size)) {
+      printf("FAIL %s bad %s index: opened\n", name, k ? "vertex" : "face");
+      failures++;
+    }
+  }
+  free(copy);
+  return failures;
+}
+
+// Each model of a bundle, opened in place, draws the orbit of the same model
+// on its own, and a bundle cut short loses its last model. Returns the
+// number of failures.
+static int check_bundle(const unsigned char *data, size_t size, int nb_models) {
+  int failures = 0;
+  use_framebuffer = true;
+  for (int i = 0; i < nb_models; i++) {
+    MeshBundleEntry entry;
+    Mesh mesh;
+    if (!mesh_bundle_entry(data, size, i, &entry) || !mesh_open(&mesh, data + entry.offset, entry.size) ||
+        mesh.version != entry.version || !render_init(&mesh)) {
+      printf("FAIL bundle model %d: cannot open\n", i);
+      failures++;
+      cases++;
+      continue;
+    }
+    memset(host_screen, 0x55, sizeof(Image));
+    render_invalidate();
+    Camera cam;
+    pose_camera(&poses[1], &mesh, &cam);
+    render_frame(&mesh, &cam);
+    failures += check(entry.name, poses[1].name, false);
+  }
+
+  MeshBundleEntry last;
+  cases++;
+  if (!mesh_bundle_entry(data, size, nb_models - 1, &last) ||
+      mesh_bundle_entry(data, last.offset + last.size - 1, nb_models - 1, &last)) {
+    printf("FAIL bundle: last model not checked against the size\n");
+    failures++;
+  }
+  MeshBundleEntry first;
+  if (mesh_bundle_entry(data, size, 0, &first)) {
+    failures += check_bad_indices(first.name, data + first.offset, first.size);
+  }
+  return failures;
+}
+
+int main(int argc, char **argv) {
+  update = argc > 1 && strcmp(argv[1], "--update") == 0;
+  if (argc < 3 + update) {
+    fprintf(stderr, "usage: golden_test [--update] refdir outdir model.bin...\n");
+    return 2;
+  }
+  ref_dir = argv[1 + update];
+  out_dir = argv[2 + update];
+  if (!fb_init()) return 2;
+
+  int failures = 0;
+  for (int arg = 3 + update; arg < argc; arg++) {
+    size_t size;
+    unsigned char *data = load(argv[arg], &size);
+    int nb_models = data ? mesh_bundle_count(data, size) : 0;
+    if (nb_models > 0) {
+      if (!update) failures += check_bundle(data, size, nb_models);
+      free(data);
+      continue;
+    }
+    Mesh mesh;
+    if (!data || !mesh_open(&mesh, data, size) || !render_init(&mesh)) {
+      fprintf(stderr, "%s: cannot open model\n", argv[arg]);
+      failures++;
+      free(data);
+      continue;
+    }
+    char model[64];
+    const char *base = strrchr(argv[arg], '/') ? strrchr(argv[arg], '/') + 1 : argv[arg];
+    snprintf(model, sizeof(model), "%.*s", (int)strcspn(base, "."), base);
+
+    for (int pixel = 0; pixel < 2; pixel++) {
+      use_framebuffer = !pixel;
+      // Poses are drawn one after the other, each frame only repaints what
+      // changed since the previous one
+      memset(host_screen, 0x55, sizeof(Image));
+      render_invalidate();
+      for (int p = 0; p < NB_POSES; p++) {
+        Camera cam;
+        pose_camera(&poses[p], &mesh, &cam);
+        render_frame(&mesh, &cam);
+        failures += check(model, poses[p].name, pixel);
+      }
+
+      // Startup view framed from the bounding sphere of the header
+      Vec3 center;
+      float radius, dist = 10.0f, scale = 50.0f;
+      if (mesh_sphere(&mesh, &center, &radius)) {
+        Camera cam;
+        camera_fit(radius, &dist, &scale);
+        camera_update(&cam, 0.0f, 0.0f, dist, scale, center.x, center.y, center.z);
+        render_frame(&mesh, &cam);
+        failures += check(model, "fit", pixel);
+      }
+
+      // Progressive frames: sliced every 64 edges the orbit is the same
+      // image, and a whole frame after a stopped one repaints what it left
+      if (!update) {
+        Camera cam;
+        render_slice_edges = 64;
+        render_poll = go_on;
+        polls = 0;
+        pose_camera(&poses[1], &mesh, &cam);
+        bool complete = render_frame(&mesh, &cam);
+        failures += check(model, poses[1].name, pixel);
+        if (!complete || polls == 0) {
+          printf("FAIL %s progressive %s: %s\n", model, pixel ? "pixel" : "strip", complete ? "never sliced" : "stopped");
+          failures++;
+        }
+
+        render_poll = stop;
+        pose_camera(&poses[0], &mesh, &cam);
+        if (render_frame(&mesh, &cam)) {
+          printf("FAIL %s stopped %s: not stopped\n", model, pixel ? "pixel" : "strip");
+          failures++;
+        }
+        render_poll = NULL;
+        render_slice_edges = RENDER_SLICE_EDGES;
+        pose_camera(&poses[1], &mesh, &cam);
+        render_frame(&mesh, &cam);
+        failures += check(model, poses[1].name, pixel);
+      }
+
+      // Coarser levels of detail from the orbit pose
+      for (int lod = 1; lod <= mesh.nb_lods; lod++) {
+        Mesh lod_mesh;
+        char name[32];
+        snprintf(name, sizeof(name), "%s-lod%d", poses[1].name, lod);
+        if (!mesh_open_lod(&mesh, lod, &lod_mesh) || !render_fits(&lod_mesh)) {
+          printf("FAIL %s %s: cannot open\n", model, name);
+          failures++;
+          continue;
+        }
+        Camera cam;
+        pose_camera(&poses[1], &mesh, &cam);
+        render_frame(&lod_mesh, &cam);
+        failures += check(model, name, pixel);
+      }
+
+      // Culling modes from the orbit pose, models without faces draw everything
+      static const char *const cull_names[CULL_MODES] = {NULL, "back", "outline"};
+      for (cull_mode = CULL_BACK; cull_mode < CULL_MODES; cull_mode++) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s-%s", poses[1].name, cull_names[cull_mode]);
+        Camera cam;
+        pose_camera(&poses[1], &mesh, &cam);
+        render_frame(&mesh, &cam);
+        failures += check(model, name, pixel);
+      }
+      cull_mode = CULL_NONE;
+
+      // Zoomed and moved across the view from the orbit, the frame reuses
+      // its projection: same image as a fresh projection
+      if (!update) {
+        static Image reused;
+        Camera cam, moved;
+        const Pose *pose = &poses[1];
+        Vec3 bbox_min, bbox_max;
+        mesh_bounds(&mesh, &bbox_min, &bbox_max);
+        pose_camera(pose, &mesh, &cam);
+        float shift = 0.1f * (bbox_max.x - bbox_min.x);
+        camera_update(&moved, pose->theta, pose->phi, pose->dist, pose->scale * 1.5f,
+                      0.5f * (bbox_min.x + bbox_max.x) + shift * cam.right.x,
+                      0.5f * (bbox_min.y + bbox_max.y) + shift * cam.right.y,
+                      0.5f * (bbox_min.z + bbox_max.z) + shift * cam.right.z);
+        render_frame(&mesh, &cam);
+        render_frame(&mesh, &moved);
+        memcpy(reused, host_screen, sizeof(Image));
+        render_init(&mesh);
+        render_invalidate();
+        render_frame(&mesh, &moved);
+        int drawn, bad = compare(reused, host_screen, &drawn);
+        if (bad * 1000 > drawn * GOLDEN_MAX_BAD) {
+          printf("FAIL %s moved %s: %d of %d pixels off the fresh projection\n", model, pixel ? "pixel" : "strip", bad, drawn);
+          failures++;
+        }
+        cases++;
+      }
+
+      // Hidden line mode, models without triangles draw everything
+      if (!render_set_hidden_lines(&mesh, true)) {
+        printf("FAIL %s hidden: no memory for the depth buffer\n", model);
+        failures++;
+        continue;
+      }
+      // The inside pose has edges across the near plane
+      for (int p = 1; p <= 3; p++) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s-hidden", poses[p].name);
+        Camera cam;
+        pose_camera(&poses[p], &mesh, &cam);
+        render_frame(&mesh, &cam);
+        failures += check(model, name, pixel);
+      }
+      render_set_hidden_lines(&mesh, false);
+
+      // Anti-aliased lines and filled mode, strip raster only. The gray
+      // shades of the lines follow the exact projection, the fixed point one
+      // is off by too much for the tolerance.
+      if (pixel) continue;
+      antialias = true;
+      for (int p = 1; p <= 2 && !FIXED_POINT; p++) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s-aa", poses[p].name);
+        Camera cam;
+        pose_camera(&poses[p], &mesh, &cam);
+        render_frame(&mesh, &cam);
+        failures += check(model, name, pixel);
+      }
+      antialias = false;
+
+      if (!render_set_filled(&mesh, true)) {
+        printf("FAIL %s filled: no memory for the vertex depths\n", model);
+        failures++;
+        continue;
+      }
+      for (int p = 1; p <= 2; p++) {
+        char name[32];
+        snprintf(name, sizeof(name), "%s-filled", poses[p].name);
+        Camera cam;
+        pose_camera(&poses[p], &mesh, &cam);
+        render_frame(&mesh, &cam);
+        failures += check(model, name, pixel);
+      }
+      render_set_filled(&mesh, false);
+    }
+    free(data);
+  }
+
+  if (!update) printf("%d/%d golden cases passed\n", cases - failures, cases);
+  return failures ? 1 : 0;
+}
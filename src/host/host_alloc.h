@@ -0,0 +1,25 @@
+#ifndef HOST_ALLOC_H
+#define HOST_ALLOC_H
+
+// Forced into the app sources by the host build so that the stub can
+// report the peak heap use, and so that the profiler reads a real clock
+
+#include <stdint.h>
+#include <stdlib.h>
+
+void *host_malloc(size_t size);
+void *host_calloc(size_t count, size_t size);
+void *host_realloc(void *p, size_t size);
+void host_free(void *p);
+
+#define malloc host_malloc
+#define calloc host_calloc
+#define realloc host_realloc
+#define free host_free
+
+// Microseconds of a monotonic clock, eadk_timing_millis is fake
+uint64_t host_clock_us();
+
+#define PROFILE_CLOCK_US host_clock_us
+
+#endif
@@ -0,0 +1,168 @@
+// Host benchmark of the vertex transform kernels: cycles per vertex (rdtsc,
+// nanoseconds without it) and millions of vertices per second of the plain
+// float and fixed point references (camera.c, the float one decodes the
+// vertices first) and of the kernels the renderer uses (transform.c),
+// whether the kernels give the same pixels as the references, the max
+// pixel error of the fixed point projection against the float one, and the
+// max relative error of the fixed point kernel's depths (1 / W) against the
+// float kernel's.
+//
+// Usage: transform_bench model.bin...
+
+#define _POSIX_C_SOURCE 199309L
+#include "../camera.h"
+#include "../mesh.h"
+#include "../transform.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#define REPEAT 20
+
+static const float poses[][4] = {
+  // theta, phi, dist, scale
+  {0.0f, 0.0f, 10.0f, 50.0f},
+  {0.8f, 0.4f, 10.0f, 50.0f},
+  {2.5f, -0.6f, 6.0f, 120.0f},
+  {4.0f, 1.2f, 20.0f, 30.0f},
+};
+
+static double now() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static uint64_t ticks() {
+#if HAVE_TSC
+  return __rdtsc();
+#else
+  return (uint64_t)(now() * 1e9);
+#endif
+}
+
+static unsigned char *load(const char *path, size_t *size) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  *size = ftell(f);
+  rewind(f);
+  unsigned char *data = malloc(*size);
+  if (data && fread(data, 1, *size, f) != *size) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  return data;
+}
+
+enum { FLOAT, FLOAT_SOA, FIXED, FIXED_KERNEL, VARIANTS };
+
+int main(int argc, char **argv) {
+  // Each kernel has its cost per vertex, then its throughput
+  printf("%-20s %8s %13s %13s %13s %13s %5s %10s %10s\n", "model", "points", "float", "float soa",
+         "fixed", "fixed kernel", "same", "max err px", "depth err");
+  const char *unit = HAVE_TSC ? "cyc/v  Mv/s" : " ns/v  Mv/s";
+  printf("%-29s %13s %13s %13s %13s\n", "", unit, unit, unit, unit);
+
+  for (int arg = 1; arg < argc; arg++) {
+    size_t size;
+    unsigned char *data = load(argv[arg], &size);
+    Mesh mesh;
+    if (!data || !mesh_open(&mesh, data, size) || !(mesh.flags & MESH_FLAG_QUANTIZED)) {
+      fprintf(stderr, "%s: not a quantized v2 model\n", argv[arg]);
+      free(data);
+      continue;
+    }
+
+    int n = mesh.nb_points;
+    Vec3 *points = malloc(n * sizeof(Vec3));
+    int (*px[VARIANTS])[2];
+    for (int v = 0; v < VARIANTS; v++) px[v] = malloc(n * sizeof(int[2]));
+    float *float_depths = malloc(n * sizeof(float)), *fixed_depths = malloc(n * sizeof(float));
+    double spent[VARIANTS] = {0};
+    uint64_t cycles[VARIANTS] = {0};
+    bool same = true;
+    int max_err = 0;
+    float depth_err = 0.0f;
+
+    for (size_t p = 0; p < sizeof(poses) / sizeof(poses[0]); p++) {
+      Camera cam;
+      FixedView fv;
+      camera_update(&cam, poses[p][0], poses[p][1], poses[p][2], poses[p][3],
+                    mesh.quant_center.x, mesh.quant_center.y, mesh.quant_center.z);
+      camera_fixed_view(&cam, mesh.quant_center, mesh.quant_scale, &fv);
+
+      for (int r = 0; r < REPEAT; r++) {
+        double t[VARIANTS + 1];
+        uint64_t c[VARIANTS + 1];
+        t[0] = now();
+        c[0] = ticks();
+        mesh_read_points(&mesh, 0, n, points);
+        transform_and_project(&cam, points, n, px[FLOAT]);
+        c[1] = ticks();
+        t[1] = now();
+        transform_mesh(&cam, &mesh, 0, n, px[FLOAT_SOA], NULL);
+        c[2] = ticks();
+        t[2] = now();
+        transform_and_project_fixed(&fv, mesh.points, n, px[FIXED]);
+        c[3] = ticks();
+        t[3] = now();
+        transform_mesh_fixed(&fv, mesh.points, n, px[FIXED_KERNEL], NULL);
+        c[4] = ticks();
+        t[4] = now();
+        for (int v = 0; v < VARIANTS; v++) {
+          spent[v] += t[v + 1] - t[v];
+          cycles[v] += c[v + 1] - c[v];
+        }
+      }
+
+      for (int i = 0; i < n; i++) {
+        // The y of points behind the near plane is left undefined
+        int k = px[FLOAT][i][0] == CLIP_BEHIND ? 1 : 2;
+        same = same && !memcmp(px[FLOAT][i], px[FLOAT_SOA][i], k * sizeof(int)) &&
+               !memcmp(px[FIXED][i], px[FIXED_KERNEL][i], (px[FIXED][i][0] == CLIP_BEHIND ? 1 : 2) * sizeof(int));
+      }
+
+      // Only compare points in front of the near plane and around the screen
+      const int (*float_px)[2] = px[FLOAT], (*fixed_px)[2] = px[FIXED];
+      for (int i = 0; i < n; i++) {
+        if (float_px[i][0] == CLIP_BEHIND || fixed_px[i][0] == CLIP_BEHIND) continue;
+        if (abs(float_px[i][0] - WIDTH / 2) > WIDTH || abs(float_px[i][1] - HEIGHT / 2) > HEIGHT) continue;
+        int err = abs(float_px[i][0] - fixed_px[i][0]);
+        if (abs(float_px[i][1] - fixed_px[i][1]) > err) err = abs(float_px[i][1] - fixed_px[i][1]);
+        if (err > max_err) max_err = err;
+      }
+
+      // Depths of the kernels, untimed, for the points in front of both
+      transform_mesh(&cam, &mesh, 0, n, px[FLOAT_SOA], float_depths);
+      transform_mesh_fixed(&fv, mesh.points, n, px[FIXED_KERNEL], fixed_depths);
+      for (int i = 0; i < n; i++) {
+        if (px[FLOAT_SOA][i][0] == CLIP_BEHIND || px[FIXED_KERNEL][i][0] == CLIP_BEHIND) continue;
+        float err = fabsf(fixed_depths[i] - float_depths[i]) / float_depths[i];
+        if (err > depth_err) depth_err = err;
+      }
+    }
+
+    double runs = (double)REPEAT * (sizeof(poses) / sizeof(poses[0])) * n;
+    const char *name = strrchr(argv[arg], '/') ? strrchr(argv[arg], '/') + 1 : argv[arg];
+    printf("%-20s %8d", name, n);
+    for (int v = 0; v < VARIANTS; v++) printf(" %7.2f %5.1f", cycles[v] / runs, runs / spent[v] * 1e-6);
+    printf(" %5s %10d %10.2e\n", same ? "yes" : "no", max_err, depth_err);
+
+    free(points);
+    free(float_depths);
+    free(fixed_depths);
+    for (int v = 0; v < VARIANTS; v++) free(px[v]);
+    free(data);
+  }
+  return 0;
+}
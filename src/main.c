@@ -1,377 +1,517 @@
-#include "eadk.h"
-#include <math.h>
-#include <stdlib.h>
-#include <stdint.h>
-#include <string.h>
-#include <stdio.h>
-
-#define WIDTH 320
-#define HEIGHT 240
-#define FOV 5.0f
-
-#define FMT_FLOAT(x) (int)(x), (int)(abs((int)(fabsf((x) * 100)) % 100))
-
-const char eadk_app_name[] __attribute__((section(".rodata.eadk_app_name"))) = "3DView";
-const uint32_t eadk_api_level  __attribute__((section(".rodata.eadk_api_level"))) = 0;
-
-typedef struct {
-  float x, y, z;
-} Vec3;
-
-int NB_POINTS = 0;
-int NB_EDGES = 0;
-
-void project(Vec3 point, int *x, int *y, float scale) {
-  float factor = FOV / (FOV + point.z);
-  *x = (int)(point.x * factor * scale + WIDTH / 2);
-  *y = (int)(-point.y * factor * scale + HEIGHT / 2);
-}
-
-Vec3 camera_transform(Vec3 p, float cam_theta, float cam_phi, float cam_dist, float cx, float cy, float cz) {
-  float ex = cx + cam_dist * cosf(cam_phi) * sinf(cam_theta);
-  float ey = cy + cam_dist * sinf(cam_phi);
-  float ez = cz + cam_dist * cosf(cam_phi) * cosf(cam_theta);
-
-  Vec3 eye = {ex, ey, ez};
-  Vec3 pt = {p.x - eye.x, p.y - eye.y, p.z - eye.z};
-
-  float up_x = 0, up_y = 1, up_z = 0;
-  float zx = cx - ex, zy = cy - ey, zz = cz - ez;
-  float zn = sqrtf(zx*zx + zy*zy + zz*zz);
-  zx /= zn; zy /= zn; zz /= zn;
-  float xx = up_y*zz - up_z*zy;
-  float xy = up_z*zx - up_x*zz;
-  float xz = up_x*zy - up_y*zx;
-  float xn = sqrtf(xx*xx + xy*xy + xz*xz);
-  xx /= xn; xy /= xn; xz /= xn;
-  float yx = zy*xz - zz*xy;
-  float yy = zz*xx - zx*xz;
-  float yz = zx*xy - zy*xx;
-
-  return (Vec3){
-    pt.x*xx + pt.y*xy + pt.z*xz,
-    pt.x*yx + pt.y*yy + pt.z*yz,
-    pt.x*zx + pt.y*zy + pt.z*zz
-  };
-}
-
-void camera_axes(float cam_theta, float cam_phi, float *forward, float *right, float *up) {
-  forward[0] = cosf(cam_phi) * sinf(cam_theta);
-  forward[1] = sinf(cam_phi);
-  forward[2] = cosf(cam_phi) * cosf(cam_theta);
-
-  right[0] = cosf(cam_theta);
-  right[1] = 0.0f;
-  right[2] = -sinf(cam_theta);
-
-  up[0] = -sinf(cam_phi) * sinf(cam_theta);
-  up[1] = cosf(cam_phi);
-  up[2] = -sinf(cam_phi) * cosf(cam_theta);
-}
-
-void draw_line(int x0, int y0, int x1, int y1, eadk_color_t color) {
-  int dx = abs(x1 - x0), dy = abs(y1 - y0);
-  int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
-  int err = dx - dy;
-  while (true) {
-    if (x0 >= 0 && x0 < WIDTH && y0 >= 0 && y0 < HEIGHT) {
-      eadk_display_push_rect((eadk_rect_t){x0, y0, 1, 1}, &color);
-    }
-    if (x0 == x1 && y0 == y1) break;
-    int e2 = 2 * err;
-    if (e2 > -dy) { err -= dy; x0 += sx; }
-    if (e2 < dx) { err += dx; y0 += sy; }
-  }
-}
-
-void screen_batch(
-  Vec3 *points, int nb_points,
-  int (*edges)[2], int nb_edges,
-  float cam_theta, float cam_phi, float cam_dist, float scale, float cx, float cy, float cz,
-  int point_offset
-) {
-  Vec3 *transformed = malloc(nb_points * sizeof(Vec3));
-  int (*projected)[2] = malloc(nb_points * sizeof(int[2]));
-  if (!transformed || !projected) {
-    eadk_display_draw_string("Erreur alloc batch", (eadk_point_t){10, 50}, false, eadk_color_red, eadk_color_white);
-    while (1);
-  }
-
-  for (int i = 0; i < nb_points; i++) {
-    Vec3 v = camera_transform(points[i], cam_theta, cam_phi, cam_dist, cx, cy, cz);
-    transformed[i] = v;
-    project(transformed[i], &projected[i][0], &projected[i][1], scale);
-  }
-
-  for (int i = 0; i < nb_edges; i++) {
-    int a = edges[i][0] - point_offset;
-    int b = edges[i][1] - point_offset;
-    if (a >= 0 && a < nb_points && b >= 0 && b < nb_points) {
-      draw_line(projected[a][0], projected[a][1],
-                projected[b][0], projected[b][1],
-                eadk_color_black);
-    }
-  }
-
-  free(transformed);
-  free(projected);
-}
-
-void screen_batches_dynamic(
-  const unsigned char *data, int32_t nb_points, int32_t nb_edges,
-  float cam_theta, float cam_phi, float cam_dist, float scale, float cx, float cy, float cz
-) {
-  int offset_points = 8;
-  int offset_edges = 8 + nb_points * sizeof(Vec3);
-
-  int points_done = 0;
-  const int BATCH_POINTS = 1500; 
-
-  Vec3 *points = malloc(BATCH_POINTS * sizeof(Vec3));
-  int (*edges_batch)[2] = malloc(BATCH_POINTS * 8 * sizeof(int[2])); 
-  if (!points || !edges_batch) {
-    eadk_display_draw_string("Erreur alloc batch", (eadk_point_t){10, 50}, false, eadk_color_red, eadk_color_white);
-    while (1);
-  }
-
-  while (points_done < nb_points) {
-    int batch_points = (points_done + BATCH_POINTS < nb_points) ? BATCH_POINTS : (nb_points - points_done);
-    memcpy(points, data + offset_points + points_done * sizeof(Vec3), batch_points * sizeof(Vec3));
-
-    int nb_edges_batch = 0;
-    for (int i = 0; i < nb_edges; i++) {
-      int a, b;
-      memcpy(&a, data + offset_edges + i * sizeof(int[2]), sizeof(int));
-      memcpy(&b, data + offset_edges + i * sizeof(int[2]) + sizeof(int), sizeof(int));
-      if (a >= points_done && a < points_done + batch_points &&
-          b >= points_done && b < points_done + batch_points) {
-        if (nb_edges_batch < BATCH_POINTS * 8) {
-          edges_batch[nb_edges_batch][0] = a;
-          edges_batch[nb_edges_batch][1] = b;
-          nb_edges_batch++;
-        }
-      }
-    }
-
-    screen_batch(points, batch_points, edges_batch, nb_edges_batch,
-                 cam_theta, cam_phi, cam_dist, scale, cx, cy, cz, points_done);
-
-    points_done += batch_points;
-  }
-
-  free(points);
-  free(edges_batch);
-}
-
-int main() {
-  eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
-  eadk_backlight_set_brightness(255);
-  eadk_display_draw_string("Loading...", (eadk_point_t){10, 10}, false, eadk_color_black, eadk_color_white);
-
-  const unsigned char *data = (const unsigned char*)eadk_external_data;
-  int32_t nb_points = 0, nb_edges = 0;
-  memcpy(&nb_points, data, 4);
-  memcpy(&nb_edges, data + 4, 4);
-  NB_POINTS = nb_points;
-  NB_EDGES = nb_edges;
-
-  float cam_theta = 0.0f;
-  float cam_phi = 0.0f;
-  float cam_dist = 10.0f;
-  float scale = 50.0f;
-  float center_x = 0.0f, center_y = 0.0f, center_z = 0.0f;
-
-  char buf[64];
-  snprintf(buf, sizeof(buf), "Points: %d, Edges: %d", NB_POINTS, NB_EDGES);
-  eadk_display_draw_string(buf, (eadk_point_t){10, 30}, false, eadk_color_black, eadk_color_white);
-  eadk_display_draw_string("Press shift to change camera distance", (eadk_point_t){10, 50}, false, eadk_color_black, eadk_color_white);
-  for (int i = 0; i < 10; i++) {
-    char buf[32];
-    snprintf(buf, "%d ms", 1000 - 100 * i);
-    eadk_display_draw_string(buf, (eadk_point_t){10, 200}, false, eadk_color_black, eadk_color_white);
-    eadk_timing_msleep(100);
-    eadk_keyboard_state_t keys = eadk_keyboard_scan();
-    if (eadk_keyboard_key_down(keys, eadk_key_shift)) {
-      eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
-      eadk_display_draw_string("Chooce camera distance ", (eadk_point_t){10, 10}, false, eadk_color_black, eadk_color_white);
-      eadk_display_draw_string("If the camera is in the model", (eadk_point_t){10, 30}, false, eadk_color_black, eadk_color_white);
-      eadk_display_draw_string("Right/left arrow to increase/decrease", (eadk_point_t){10, 50}, false, eadk_color_black, eadk_color_white);
-      eadk_display_draw_string("or up/down to increase/decrease * 10", (eadk_point_t){10, 70}, false, eadk_color_black, eadk_color_white);
-      eadk_display_draw_string("Press ok to continue", (eadk_point_t){10, 90}, false, eadk_color_black, eadk_color_white);
-      snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
-      eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
-      while (1){
-        eadk_keyboard_state_t keys = eadk_keyboard_scan();
-        if (eadk_keyboard_key_down(keys, eadk_key_home)) {
-          return 0;
-        }
-        if (eadk_keyboard_key_down(keys, eadk_key_right)) {
-          cam_dist += 0.5f;
-          snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
-          eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
-          eadk_timing_msleep(50);
-        }
-        if (eadk_keyboard_key_down(keys, eadk_key_left)) {
-          cam_dist -= 0.5f;
-          if (cam_dist < 0.5f) cam_dist = 0.5f;
-          snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
-          eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
-          eadk_timing_msleep(50);
-        }
-        if (eadk_keyboard_key_down(keys, eadk_key_up)) {
-          cam_dist += 5.0f;
-          snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
-          eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
-          eadk_timing_msleep(50);
-        }
-        if (eadk_keyboard_key_down(keys, eadk_key_down)) {
-          cam_dist -= 5.0f;
-          if (cam_dist < 0.5f) cam_dist = 0.5f;
-          snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
-          eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
-          eadk_timing_msleep(50);
-        }
-        if (eadk_keyboard_key_down(keys, eadk_key_ok)) {
-          break;
-        }
-      }
-    }
-  }
-
-  eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
-  screen_batches_dynamic(data, NB_POINTS, NB_EDGES, cam_theta, cam_phi, cam_dist, scale, center_x, center_y, center_z);
-
-  bool is_debug = false;
-  bool is_cam_mode = false;
-
-  uint32_t elapsed = 0;
-
-  while (true) {
-    bool redraw = false;
-
-    eadk_keyboard_state_t keys = eadk_keyboard_scan();
-
-    float cam_speed = 0.02f * ((float)elapsed / 60.0f);
-    float move_speed = 0.05f * ((float)elapsed / 60.0f);
-
-    if (!is_cam_mode) {
-      if (eadk_keyboard_key_down(keys, eadk_key_imaginary)) {
-        cam_theta += cam_speed;
-        redraw = true;
-      }
-      if (eadk_keyboard_key_down(keys, eadk_key_power)) {
-        cam_theta -= cam_speed;
-        redraw = true;
-      }
-      if (eadk_keyboard_key_down(keys, eadk_key_toolbox)) {
-        cam_phi += cam_speed;
-        if (cam_phi > 1.5f) cam_phi = 1.5f;
-        redraw = true;
-      }
-      if (eadk_keyboard_key_down(keys, eadk_key_sqrt)) {
-        cam_phi -= cam_speed;
-        if (cam_phi < -1.5f) cam_phi = -1.5f;
-        redraw = true;
-      }
-
-      float forward[3], right[3], up[3];
-      camera_axes(cam_theta, cam_phi, forward, right, up);
-
-      if (eadk_keyboard_key_down(keys, eadk_key_up)) {
-        center_x += up[0] * move_speed;
-        center_y += up[1] * move_speed;
-        center_z += up[2] * move_speed;
-        redraw = true;
-      }
-      if (eadk_keyboard_key_down(keys, eadk_key_down)) {
-        center_x -= up[0] * move_speed;
-        center_y -= up[1] * move_speed;
-        center_z -= up[2] * move_speed;
-        redraw = true;
-      }
-      if (eadk_keyboard_key_down(keys, eadk_key_left)) {
-        center_x += right[0] * move_speed;
-        center_y += right[1] * move_speed;
-        center_z += right[2] * move_speed;
-        redraw = true;
-      }
-      if (eadk_keyboard_key_down(keys, eadk_key_right)) {
-        center_x -= right[0] * move_speed;
-        center_y -= right[1] * move_speed;
-        center_z -= right[2] * move_speed;
-        redraw = true;
-      }
-
-      if (eadk_keyboard_key_down(keys, eadk_key_ok)) {
-        scale *= 1.05f;
-        redraw = true;
-      }
-      if (eadk_keyboard_key_down(keys, eadk_key_back)) {
-        scale /= 1.05f;
-        redraw = true;
-      }
-    }
-
-    if (eadk_keyboard_key_down(keys, eadk_key_home)) {
-      return 0;
-    }
-
-    if (eadk_keyboard_key_down(keys, eadk_key_shift)) {
-      is_debug = !is_debug;
-      redraw = true;
-      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
-    }
-
-    if (eadk_keyboard_key_down(keys, eadk_key_zero)) {
-      is_cam_mode = !is_cam_mode;
-      redraw = true;
-      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
-    }
-
-    if (!is_cam_mode){
-      if (redraw) {
-        uint32_t start = (uint32_t)eadk_timing_millis();
-        eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
-        screen_batches_dynamic(data, NB_POINTS, NB_EDGES, cam_theta, cam_phi, cam_dist, scale, center_x, center_y, center_z);
-        uint32_t end = (uint32_t)eadk_timing_millis();
-        elapsed = end - start;
-      }
-    }
-    else {
-      uint32_t start = (uint32_t)eadk_timing_millis();
-
-      cam_theta -= cam_speed;
-
-      eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
-      screen_batches_dynamic(data, NB_POINTS, NB_EDGES, cam_theta, cam_phi, cam_dist, scale, center_x, center_y, center_z);
-      eadk_display_draw_string("Camera Mode... Press 0 to quit", (eadk_point_t){0, 225}, false, eadk_color_black, eadk_color_white);
-
-      uint32_t end = (uint32_t)eadk_timing_millis();
-      elapsed = end - start;
-    }
-
-    if (is_debug) {
-      char buf[192];
-      snprintf(buf, sizeof(buf),
-        "Cam: theta=%d.%02d, phi=%d.%02d, scale=%d.%02d\n"
-        "Center: (%d.%02d, %d.%02d, %d.%02d)\n"
-        "Cam_speed: %d.%02d, Move_speed: %d.%02d\n"
-        "Framerate: %u ms\n"
-        "Sleep: %u ms",
-        FMT_FLOAT(cam_theta), FMT_FLOAT(cam_phi), FMT_FLOAT(scale),
-        FMT_FLOAT(center_x), FMT_FLOAT(center_y), FMT_FLOAT(center_z), 
-        FMT_FLOAT(cam_speed), FMT_FLOAT(move_speed),
-        elapsed,
-        elapsed < 60 ? 60 - elapsed : 0
-      );
-      eadk_display_draw_string(buf, (eadk_point_t){0, 0}, false, eadk_color_black, eadk_color_white);
-    }
-
-
-    if (elapsed < 60) {
-      eadk_timing_msleep(60 - elapsed);
-    }
-  }
-
-  return 0;
-}
+#include "eadk.h"
+#include "camera.h"
+#include "framebuffer.h"
+#include "mesh.h"
+#include "profile.h"
+#include "render.h"
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#define SMALL_FONT_HEIGHT 14
+// Models listed at once by the bundle picker
+#define PICKER_ROWS 11
+// While the camera keys are held, the finest level of detail whose last
+// frame took at most this long is drawn
+#define MOTION_FRAME_MS 40
+#define KEY_BIT(key) ((eadk_keyboard_state_t)1 << (key))
+#define FMT_FLOAT(x) (int)(x), (int)(abs((int)(fabsf((x) * 100)) % 100))
+
+const char eadk_app_name[] __attribute__((section(".rodata.eadk_app_name"))) = "3DView";
+const uint32_t eadk_api_level  __attribute__((section(".rodata.eadk_api_level"))) = 0;
+
+int NB_POINTS = 0;
+int NB_EDGES = 0;
+
+static const eadk_keyboard_state_t motion_keys =
+  KEY_BIT(eadk_key_imaginary) | KEY_BIT(eadk_key_power) | KEY_BIT(eadk_key_toolbox) | KEY_BIT(eadk_key_sqrt) |
+  KEY_BIT(eadk_key_up) | KEY_BIT(eadk_key_down) | KEY_BIT(eadk_key_left) | KEY_BIT(eadk_key_right) |
+  KEY_BIT(eadk_key_ok) | KEY_BIT(eadk_key_back);
+
+static const char *const cull_names[CULL_MODES] = {"off", "back faces", "outline"};
+
+// Stops a progressive frame as soon as a key is down, the camera is about
+// to change
+static bool key_pressed() {
+  return eadk_keyboard_scan() != 0;
+}
+
+// Levels not drawn yet count as fast enough
+static int pick_level(const uint32_t *level_ms, int nb_levels) {
+  for (int level = 0; level < nb_levels - 1; level++) {
+    if (level_ms[level] <= MOTION_FRAME_MS) return level;
+  }
+  return nb_levels - 1;
+}
+
+// Nothing can be drawn, waits for home
+static int model_too_large() {
+  eadk_display_draw_string("Model too large for the memory", (eadk_point_t){10, 30}, false, eadk_color_red, eadk_color_white);
+  eadk_display_draw_string("Convert a smaller one", (eadk_point_t){10, 50}, false, eadk_color_red, eadk_color_white);
+  while (!eadk_keyboard_key_down(eadk_keyboard_scan(), eadk_key_home)) eadk_timing_msleep(100);
+  return 0;
+}
+
+// Line of the picker, padded to the width of the screen so that it erases
+// the previous one
+static void draw_row(const char *text, int y, bool selected) {
+  char row[48];
+  snprintf(row, sizeof(row), "%-44s", text);
+  eadk_display_draw_string(row, (eadk_point_t){10, y}, false, selected ? eadk_color_white : eadk_color_black,
+                           selected ? eadk_color_black : eadk_color_white);
+}
+
+// Lists the models of a bundle, up and down choose one, ok opens it.
+// Returns its index, or -1 for home.
+static int pick_model(const void *data, size_t size, int nb_models) {
+  int selected = 0, top = 0;
+  bool redraw = true;
+  eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
+  eadk_display_draw_string("Choose a model, up/down then ok", (eadk_point_t){10, 10}, false, eadk_color_black, eadk_color_white);
+  while (true) {
+    if (redraw) {
+      if (selected < top) top = selected;
+      if (selected >= top + PICKER_ROWS) top = selected - PICKER_ROWS + 1;
+      char buf[64];
+      for (int row = 0; row < PICKER_ROWS; row++) {
+        int index = top + row;
+        MeshBundleEntry entry;
+        if (index >= nb_models) {
+          buf[0] = '\0';
+        } else if (mesh_bundle_entry(data, size, index, &entry)) {
+          snprintf(buf, sizeof(buf), "%-23s v%d %6u KB", entry.name, entry.version, (unsigned)((entry.size + 1023) / 1024));
+        } else {
+          snprintf(buf, sizeof(buf), "Model %d: out of the data", index + 1);
+        }
+        draw_row(buf, 40 + row * SMALL_FONT_HEIGHT, index == selected);
+      }
+      // Size of the selected model from its bounds, without opening it
+      MeshBundleEntry entry;
+      buf[0] = '\0';
+      if (mesh_bundle_entry(data, size, selected, &entry)) {
+        snprintf(buf, sizeof(buf), "Size %d.%02d x %d.%02d x %d.%02d",
+                 FMT_FLOAT(entry.bbox_max[0] - entry.bbox_min[0]), FMT_FLOAT(entry.bbox_max[1] - entry.bbox_min[1]),
+                 FMT_FLOAT(entry.bbox_max[2] - entry.bbox_min[2]));
+      }
+      draw_row(buf, 210, false);
+      redraw = false;
+    }
+    eadk_keyboard_state_t keys = eadk_keyboard_scan();
+    if (eadk_keyboard_key_down(keys, eadk_key_home)) return -1;
+    if (eadk_keyboard_key_down(keys, eadk_key_ok)) {
+      // The main loop would see the same press
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+      return selected;
+    }
+    if (eadk_keyboard_key_down(keys, eadk_key_up) && selected > 0) {
+      selected--;
+      redraw = true;
+    }
+    if (eadk_keyboard_key_down(keys, eadk_key_down) && selected < nb_models - 1) {
+      selected++;
+      redraw = true;
+    }
+    eadk_timing_msleep(redraw ? 150 : 20);
+  }
+}
+
+int main() {
+  eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
+  eadk_backlight_set_brightness(255);
+
+  // A bundle maps the chosen model in place, the others are never read
+  const char *data = eadk_external_data;
+  size_t size = eadk_external_data_size;
+  int nb_models = mesh_bundle_count(data, size);
+  MeshBundleEntry entry = {0};
+  if (nb_models > 0) {
+    int index = nb_models == 1 ? 0 : pick_model(data, size, nb_models);
+    if (index < 0) return 0;
+    eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
+    if (mesh_bundle_entry(data, size, index, &entry)) {
+      data += entry.offset;
+      size = entry.size;
+    } else {
+      size = 0;
+    }
+  }
+  eadk_display_draw_string("Loading...", (eadk_point_t){10, 10}, false, eadk_color_black, eadk_color_white);
+
+  Mesh mesh;
+  if (!mesh_open(&mesh, data, size) || (nb_models > 0 && mesh.version != entry.version)) {
+    eadk_display_draw_string("Invalid model data, convert it again", (eadk_point_t){10, 30}, false, eadk_color_red, eadk_color_white);
+    while (!eadk_keyboard_key_down(eadk_keyboard_scan(), eadk_key_home)) eadk_timing_msleep(100);
+    return 0;
+  }
+  NB_POINTS = mesh.nb_points;
+  NB_EDGES = mesh.nb_edges;
+
+  // Every mode starts off, also when the host tools run main again
+  cull_mode = CULL_NONE;
+  hidden_lines = false;
+  filled = false;
+  antialias = false;
+  render_poll = key_pressed;
+  profile_enabled = false;
+  profile_reset();
+  use_framebuffer = fb_init();
+  bool fits = render_init(&mesh);
+  if (!fits && use_framebuffer) {
+    // The model comes first, draw straight to the screen
+    fb_free();
+    use_framebuffer = false;
+    fits = render_init(&mesh);
+  }
+  if (!fits) return model_too_large();
+
+  // Level 0 is the full model, then the coarser levels of detail
+  Mesh levels[1 + MESH_MAX_LODS];
+  int nb_levels = 1;
+  levels[0] = mesh;
+  for (int lod = 1; lod <= mesh.nb_lods; lod++) {
+    if (mesh_open_lod(&mesh, lod, &levels[nb_levels]) && render_fits(&levels[nb_levels])) nb_levels++;
+  }
+  uint32_t level_ms[1 + MESH_MAX_LODS] = {0};
+  int level = 0;
+
+  float cam_theta = 0.0f;
+  float cam_phi = 0.0f;
+  float cam_dist = 10.0f;
+  float scale = 50.0f;
+  float center_x = 0.0f, center_y = 0.0f, center_z = 0.0f;
+  // Framed from the header, without reading the vertices. v1 models keep the
+  // defaults, the shift menu still changes the distance.
+  Vec3 center;
+  float radius;
+  if (mesh_sphere(&mesh, &center, &radius)) {
+    center_x = center.x;
+    center_y = center.y;
+    center_z = center.z;
+    camera_fit(radius, &cam_dist, &scale);
+  }
+
+  char buf[64];
+  snprintf(buf, sizeof(buf), "Points: %d, Edges: %d", NB_POINTS, NB_EDGES);
+  eadk_display_draw_string(buf, (eadk_point_t){10, 30}, false, eadk_color_black, eadk_color_white);
+  eadk_display_draw_string("Press shift to change camera distance", (eadk_point_t){10, 50}, false, eadk_color_black, eadk_color_white);
+  for (int i = 0; i < 10; i++) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%d ms", 1000 - 100 * i);
+    eadk_display_draw_string(buf, (eadk_point_t){10, 200}, false, eadk_color_black, eadk_color_white);
+    eadk_timing_msleep(100);
+    eadk_keyboard_state_t keys = eadk_keyboard_scan();
+    if (eadk_keyboard_key_down(keys, eadk_key_shift)) {
+      eadk_display_push_rect_uniform(eadk_screen_rect, eadk_color_white);
+      eadk_display_draw_string("Chooce camera distance ", (eadk_point_t){10, 10}, false, eadk_color_black, eadk_color_white);
+      eadk_display_draw_string("If the camera is in the model", (eadk_point_t){10, 30}, false, eadk_color_black, eadk_color_white);
+      eadk_display_draw_string("Right/left arrow to increase/decrease", (eadk_point_t){10, 50}, false, eadk_color_black, eadk_color_white);
+      eadk_display_draw_string("or up/down to increase/decrease * 10", (eadk_point_t){10, 70}, false, eadk_color_black, eadk_color_white);
+      eadk_display_draw_string("Press ok to continue", (eadk_point_t){10, 90}, false, eadk_color_black, eadk_color_white);
+      snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
+      eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
+      while (1){
+        eadk_keyboard_state_t keys = eadk_keyboard_scan();
+        if (eadk_keyboard_key_down(keys, eadk_key_home)) {
+          return 0;
+        }
+        if (eadk_keyboard_key_down(keys, eadk_key_right)) {
+          cam_dist += 0.5f;
+          snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
+          eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
+          eadk_timing_msleep(50);
+        }
+        if (eadk_keyboard_key_down(keys, eadk_key_left)) {
+          cam_dist -= 0.5f;
+          if (cam_dist < 0.5f) cam_dist = 0.5f;
+          snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
+          eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
+          eadk_timing_msleep(50);
+        }
+        if (eadk_keyboard_key_down(keys, eadk_key_up)) {
+          cam_dist += 5.0f;
+          snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
+          eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
+          eadk_timing_msleep(50);
+        }
+        if (eadk_keyboard_key_down(keys, eadk_key_down)) {
+          cam_dist -= 5.0f;
+          if (cam_dist < 0.5f) cam_dist = 0.5f;
+          snprintf(buf, sizeof(buf), "Camera distance: %d.%02d", (int)cam_dist, (int)(fabsf(cam_dist * 100)) % 100);
+          eadk_display_draw_string(buf, (eadk_point_t){10, 130}, false, eadk_color_black, eadk_color_white);
+          eadk_timing_msleep(50);
+        }
+        if (eadk_keyboard_key_down(keys, eadk_key_ok)) {
+          break;
+        }
+      }
+    }
+  }
+
+  Camera cam;
+  camera_update(&cam, cam_theta, cam_phi, cam_dist, scale, center_x, center_y, center_z);
+  render_invalidate();
+  // A frame stopped by a key is drawn again once the keys are released
+  bool complete = render_frame(&mesh, &cam);
+
+  bool is_debug = false;
+  bool is_cam_mode = false;
+  // Fly-through stress path: the camera crosses the model along its diagonal
+  bool is_fly_mode = false;
+  float fly_t = 0.0f;
+  // Read when the fly mode first starts, a v1 model has to scan its vertices
+  bool has_bbox = false;
+  Vec3 bbox_min, bbox_max;
+
+  uint32_t elapsed = 0;
+  // Last frame time of the per-pixel path [0] and of the strip framebuffer [1]
+  uint32_t backend_ms[2] = {0, 0};
+
+  while (true) {
+    bool redraw = false;
+
+    eadk_keyboard_state_t keys = eadk_keyboard_scan();
+
+    float cam_speed = 0.02f * ((float)elapsed / 60.0f);
+    float move_speed = 0.05f * ((float)elapsed / 60.0f);
+
+    if (!is_cam_mode && !is_fly_mode) {
+      if (eadk_keyboard_key_down(keys, eadk_key_imaginary)) {
+        cam_theta += cam_speed;
+        redraw = true;
+      }
+      if (eadk_keyboard_key_down(keys, eadk_key_power)) {
+        cam_theta -= cam_speed;
+        redraw = true;
+      }
+      if (eadk_keyboard_key_down(keys, eadk_key_toolbox)) {
+        cam_phi += cam_speed;
+        if (cam_phi > 1.5f) cam_phi = 1.5f;
+        redraw = true;
+      }
+      if (eadk_keyboard_key_down(keys, eadk_key_sqrt)) {
+        cam_phi -= cam_speed;
+        if (cam_phi < -1.5f) cam_phi = -1.5f;
+        redraw = true;
+      }
+
+      float forward[3], right[3], up[3];
+      camera_update(&cam, cam_theta, cam_phi, cam_dist, scale, center_x, center_y, center_z);
+      camera_axes(&cam, forward, right, up);
+
+      if (eadk_keyboard_key_down(keys, eadk_key_up)) {
+        center_x += up[0] * move_speed;
+        center_y += up[1] * move_speed;
+        center_z += up[2] * move_speed;
+        redraw = true;
+      }
+      if (eadk_keyboard_key_down(keys, eadk_key_down)) {
+        center_x -= up[0] * move_speed;
+        center_y -= up[1] * move_speed;
+        center_z -= up[2] * move_speed;
+        redraw = true;
+      }
+      if (eadk_keyboard_key_down(keys, eadk_key_left)) {
+        center_x += right[0] * move_speed;
+        center_y += right[1] * move_speed;
+        center_z += right[2] * move_speed;
+        redraw = true;
+      }
+      if (eadk_keyboard_key_down(keys, eadk_key_right)) {
+        center_x -= right[0] * move_speed;
+        center_y -= right[1] * move_speed;
+        center_z -= right[2] * move_speed;
+        redraw = true;
+      }
+
+      if (eadk_keyboard_key_down(keys, eadk_key_ok)) {
+        scale *= 1.05f;
+        redraw = true;
+      }
+      if (eadk_keyboard_key_down(keys, eadk_key_back)) {
+        scale /= 1.05f;
+        redraw = true;
+      }
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_home)) {
+      return 0;
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_shift)) {
+      is_debug = !is_debug;
+      render_invalidate();
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_zero)) {
+      is_cam_mode = !is_cam_mode;
+      render_invalidate();
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_one)) {
+      is_fly_mode = !is_fly_mode;
+      if (is_fly_mode && !has_bbox) {
+        mesh_bounds(&mesh, &bbox_min, &bbox_max);
+        has_bbox = true;
+      }
+      render_invalidate();
+      fly_t = 0.0f;
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_two)) {
+      cull_mode = (cull_mode + 1) % CULL_MODES;
+      render_invalidate();
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_three)) {
+      if (!render_set_hidden_lines(&mesh, !hidden_lines)) {
+        if (!render_fits(&mesh)) return model_too_large();
+        eadk_display_draw_string("Not enough memory for hidden lines", (eadk_point_t){0, 225}, false, eadk_color_red, eadk_color_white);
+        eadk_timing_msleep(1000);
+      }
+      render_invalidate();
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_four)) {
+      if (!filled && !use_framebuffer) {
+        eadk_display_draw_string("Filled faces need the strip raster (x,n,t)", (eadk_point_t){0, 225}, false, eadk_color_red, eadk_color_white);
+        eadk_timing_msleep(1000);
+      } else if (!render_set_filled(&mesh, !filled)) {
+        if (!render_fits(&mesh)) return model_too_large();
+        eadk_display_draw_string("Not enough memory for filled faces", (eadk_point_t){0, 225}, false, eadk_color_red, eadk_color_white);
+        eadk_timing_msleep(1000);
+      }
+      render_invalidate();
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_five)) {
+      antialias = !antialias;
+      render_invalidate();
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_var)) {
+      profile_enabled = !profile_enabled;
+      profile_reset();
+      render_invalidate();
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (eadk_keyboard_key_down(keys, eadk_key_xnt) && fb.pixels) {
+      use_framebuffer = !use_framebuffer;
+      render_invalidate();
+      redraw = true;
+      while (eadk_keyboard_scan() != 0) eadk_timing_msleep(100);
+    }
+
+    if (is_fly_mode) {
+      uint32_t start = (uint32_t)eadk_timing_millis();
+
+      // One crossing every 8 s of rendering, whatever the frame time
+      fly_t += (float)(elapsed < 60 ? 60 : elapsed) / 8000.0f;
+      if (fly_t >= 1.0f) fly_t -= 1.0f;
+
+      camera_fly_through(&cam, fly_t, bbox_min, bbox_max, scale);
+      level = 0;
+      complete = render_frame(&mesh, &cam);
+      eadk_display_draw_string("Fly-through... Press 1 to quit", (eadk_point_t){0, 225}, false, eadk_color_black, eadk_color_white);
+
+      uint32_t end = (uint32_t)eadk_timing_millis();
+      elapsed = end - start;
+      if (complete) backend_ms[use_framebuffer] = elapsed;
+    }
+    else if (!is_cam_mode){
+      // Coarse while moving, then the full model once the keys are released
+      bool moving = keys & motion_keys;
+      if (redraw || (!moving && (level > 0 || !complete))) {
+        level = moving ? pick_level(level_ms, nb_levels) : 0;
+        uint32_t start = (uint32_t)eadk_timing_millis();
+        camera_update(&cam, cam_theta, cam_phi, cam_dist, scale, center_x, center_y, center_z);
+        complete = render_frame(&levels[level], &cam);
+        uint32_t end = (uint32_t)eadk_timing_millis();
+        elapsed = end - start;
+        // A stopped frame says nothing of the time of a whole one
+        if (complete) {
+          backend_ms[use_framebuffer] = elapsed;
+          level_ms[level] = elapsed;
+        }
+      }
+    }
+    else {
+      uint32_t start = (uint32_t)eadk_timing_millis();
+
+      cam_theta -= cam_speed;
+
+      camera_update(&cam, cam_theta, cam_phi, cam_dist, scale, center_x, center_y, center_z);
+      level = 0;
+      complete = render_frame(&mesh, &cam);
+      eadk_display_draw_string("Camera Mode... Press 0 to quit", (eadk_point_t){0, 225}, false, eadk_color_black, eadk_color_white);
+
+      uint32_t end = (uint32_t)eadk_timing_millis();
+      elapsed = end - start;
+      if (complete) backend_ms[use_framebuffer] = elapsed;
+    }
+
+    if (profile_enabled) {
+      // Instead of the debug text, both do not fit
+      char buf[512];
+      int lines = profile_format(buf, sizeof(buf));
+      eadk_display_draw_string(buf, (eadk_point_t){0, 0}, false, eadk_color_black, eadk_color_white);
+      render_overdrawn((eadk_rect_t){0, 0, EADK_SCREEN_WIDTH, lines * SMALL_FONT_HEIGHT});
+    } else if (is_debug) {
+      char buf[512];
+      snprintf(buf, sizeof(buf),
+        "Cam: theta=%d.%02d, phi=%d.%02d, scale=%d.%02d\n"
+        "Center: (%d.%02d, %d.%02d, %d.%02d)\n"
+        "Cam_speed: %d.%02d, Move_speed: %d.%02d\n"
+        "Framerate: %u ms\n"
+        "Sleep: %u ms\n"
+        "Raster: %s (x,n,t) strip=%u ms, pixel=%u ms\n"
+        "Pushed: %u px in %u calls\n"
+        "Detail: level %d of %d, %d edges, %u chunks off view\n"
+        "Culling: %s (2), %u drawn, %u culled\n"
+        "Hidden lines: %s (3), filled: %s (4, strip)\n"
+        "Anti-aliasing: %s (5, strip)\n"
+        "Triangles: %u in %u ms",
+        FMT_FLOAT(cam_theta), FMT_FLOAT(cam_phi), FMT_FLOAT(scale),
+        FMT_FLOAT(center_x), FMT_FLOAT(center_y), FMT_FLOAT(center_z), 
+        FMT_FLOAT(cam_speed), FMT_FLOAT(move_speed),
+        elapsed,
+        elapsed < 60 ? 60 - elapsed : 0,
+        use_framebuffer ? "strip" : "pixel", backend_ms[1], backend_ms[0],
+        (unsigned)push_stats.pixels, (unsigned)push_stats.calls,
+        level, nb_levels - 1, levels[level].nb_edges, (unsigned)edge_stats.chunks_off,
+        cull_names[cull_mode], (unsigned)edge_stats.edges, (unsigned)edge_stats.culled,
+        hidden_lines ? "on" : "off", filled ? "on" : "off",
+        antialias ? "on" : "off",
+        (unsigned)triangle_stats.triangles, (unsigned)triangle_stats.ms
+      );
+      eadk_display_draw_string(buf, (eadk_point_t){0, 0}, false, eadk_color_black, eadk_color_white);
+      int lines = 1;
+      for (const char *c = buf; *c; c++) lines += *c == '\n';
+      render_overdrawn((eadk_rect_t){0, 0, EADK_SCREEN_WIDTH, lines * SMALL_FONT_HEIGHT});
+    }
+
+
+    if (elapsed < 60) {
+      eadk_timing_msleep(60 - elapsed);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,296 @@
+#include "mesh.h"
+#include <math.h>
+
+static bool in_bounds(size_t size, uint32_t offset, uint64_t length) {
+  return offset <= size && length <= size - offset;
+}
+
+static bool open_v1(Mesh *mesh, const uint8_t *data, size_t size) {
+  int32_t nb_points, nb_edges;
+  memcpy(&nb_points, data, 4);
+  memcpy(&nb_edges, data + 4, 4);
+  if (nb_points < 0 || nb_edges < 0) return false;
+  uint64_t points_size = (uint64_t)nb_points * sizeof(float[3]);
+  if (!in_bounds(size, 8, points_size + (uint64_t)nb_edges * sizeof(int32_t[2]))) return false;
+
+  mesh->version = 1;
+  mesh->nb_points = nb_points;
+  mesh->nb_edges = nb_edges;
+  mesh->points = data + 8;
+  mesh->edges = data + 8 + points_size;
+  return true;
+}
+
+static bool open_v2(Mesh *mesh, const uint8_t *data, size_t size) {
+  MeshHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(&h, data, 8);
+  if (h.version != MESH_VERSION || h.header_size < MESH_HEADER_BASE_SIZE || !in_bounds(size, 0, h.header_size)) return false;
+  memcpy(&h, data, h.header_size < sizeof(h) ? h.header_size : sizeof(h));
+
+  mesh->has_bounds = h.header_size >= offsetof(MeshHeader, quant_scale) + sizeof(h.quant_scale);
+  if ((h.flags & MESH_FLAG_QUANTIZED) && !mesh->has_bounds) return false;
+  if ((h.flags & MESH_FLAG_EDGES16) && (h.chunk_points > 65536 || (h.nb_points > 65536 && !(h.flags & MESH_FLAG_CROSS_VARINT)))) return false;
+  bool strips = h.flags & MESH_FLAG_STRIPS;
+  if (strips && (!(h.flags & MESH_FLAG_EDGES16) || h.header_size < offsetof(MeshHeader, strips_offset) + sizeof(h.strips_offset))) return false;
+
+  if (h.chunk_points == 0 || h.nb_chunks != (h.nb_points + h.chunk_points - 1) / h.chunk_points) return false;
+  if (h.nb_cross_edges > h.nb_edges) return false;
+  uint32_t nb_chunk_edges = h.nb_edges - h.nb_cross_edges;
+  size_t point_size = (h.flags & MESH_FLAG_QUANTIZED) ? sizeof(int16_t[3]) : sizeof(float[3]);
+  size_t edge_size = (h.flags & MESH_FLAG_EDGES16) ? sizeof(uint16_t[2]) : sizeof(int32_t[2]);
+  // Varint and strip cross edges are bounded by the end of the data while
+  // reading, so are the strips of a chunk by the next one
+  uint64_t cross_size = (h.flags & (MESH_FLAG_CROSS_VARINT | MESH_FLAG_STRIPS)) ? 0 : (uint64_t)h.nb_cross_edges * edge_size;
+  if (!in_bounds(size, h.points_offset, (uint64_t)h.nb_points * point_size) ||
+      !in_bounds(size, h.chunks_offset, ((uint64_t)h.nb_chunks + 1) * sizeof(uint32_t)) ||
+      (strips && !in_bounds(size, h.strips_offset, ((uint64_t)h.nb_chunks + 1) * sizeof(uint32_t))) ||
+      (!strips && !in_bounds(size, h.edges_offset, (uint64_t)nb_chunk_edges * edge_size)) ||
+      !in_bounds(size, h.cross_offset, cross_size)) {
+    return false;
+  }
+
+  const uint8_t *chunks = data + h.chunks_offset;
+  uint32_t previous = 0;
+  for (uint32_t c = 0; c <= h.nb_chunks; c++) {
+    uint32_t first = mesh_u32(chunks + c * sizeof(uint32_t));
+    if (first < previous || (c == 0 && first != 0)) return false;
+    previous = first;
+  }
+  if (previous != nb_chunk_edges) return false;
+  if (strips) {
+    previous = 0;
+    for (uint32_t c = 0; c <= h.nb_chunks; c++) {
+      uint32_t first = mesh_u32(data + h.strips_offset + c * sizeof(uint32_t));
+      if (first < previous || (c == 0 && first != 0)) return false;
+      previous = first;
+    }
+    if (!in_bounds(size, h.edges_offset, (uint64_t)previous * sizeof(uint16_t))) return false;
+  }
+
+  // nb_lods stays 0 when the header is too short to have it
+  if (h.nb_lods > 0 && (h.nb_lods > MESH_MAX_LODS || !in_bounds(size, h.lods_offset, (uint64_t)h.nb_lods * 8))) return false;
+  if (h.nb_faces > 0 && (h.nb_faces >= MESH_NO_FACE ||
+                         !in_bounds(size, h.faces_offset, (uint64_t)h.nb_faces * 8) ||
+                         !in_bounds(size, h.adjacency_offset, (uint64_t)h.nb_edges * sizeof(uint16_t[2])))) {
+    return false;
+  }
+  if (h.nb_triangles > 0 && (h.nb_points > 65536 || !in_bounds(size, h.triangles_offset, (uint64_t)h.nb_triangles * sizeof(uint16_t[3])))) {
+    return false;
+  }
+  if (h.boxes_offset && (!(h.flags & MESH_FLAG_QUANTIZED) || !in_bounds(size, h.boxes_offset, (uint64_t)h.nb_chunks * sizeof(int16_t[6])))) {
+    return false;
+  }
+  if (h.nb_faces > 0) {
+    // The fans of the faces make the triangle list
+    uint32_t nb_triangles = 0;
+    for (uint32_t f = 0; f < h.nb_faces; f++) nb_triangles += data[h.faces_offset + f * 8 + 3];
+    if (nb_triangles != h.nb_triangles) return false;
+    // The renderer looks the faces of the edges up without checking them
+    for (uint64_t i = 0; i < (uint64_t)h.nb_edges * 2; i++) {
+      uint16_t f;
+      memcpy(&f, data + h.adjacency_offset + i * sizeof(f), sizeof(f));
+      if (f >= h.nb_faces && f != MESH_NO_FACE) return false;
+    }
+  }
+  // and the vertices of the triangles
+  for (uint64_t i = 0; i < (uint64_t)h.nb_triangles * 3; i++) {
+    uint16_t v;
+    memcpy(&v, data + h.triangles_offset + i * sizeof(v), sizeof(v));
+    if (v >= h.nb_points) return false;
+  }
+
+  mesh->version = 2;
+  mesh->flags = h.flags;
+  mesh->nb_points = h.nb_points;
+  mesh->nb_edges = h.nb_edges;
+  mesh->points = data + h.points_offset;
+  mesh->edges = data + h.edges_offset;
+  mesh->chunk_points = h.chunk_points;
+  mesh->nb_chunks = h.nb_chunks;
+  mesh->chunks = chunks;
+  if (strips) mesh->strips = data + h.strips_offset;
+  if (h.boxes_offset) mesh->boxes = data + h.boxes_offset;
+  mesh->nb_cross_edges = h.nb_cross_edges;
+  mesh->cross_edges = data + h.cross_offset;
+  if (h.nb_lods > 0) {
+    mesh->nb_lods = h.nb_lods;
+    mesh->lods = data + h.lods_offset;
+  }
+  if (h.nb_faces > 0) {
+    mesh->nb_faces = h.nb_faces;
+    mesh->faces = data + h.faces_offset;
+    mesh->adjacency = data + h.adjacency_offset;
+  }
+  if (h.nb_triangles > 0) {
+    mesh->nb_triangles = h.nb_triangles;
+    mesh->triangles = data + h.triangles_offset;
+  }
+  if (mesh->has_bounds) {
+    mesh->bbox_min = (Vec3){h.bbox_min[0], h.bbox_min[1], h.bbox_min[2]};
+    mesh->bbox_max = (Vec3){h.bbox_max[0], h.bbox_max[1], h.bbox_max[2]};
+    mesh->quant_center = (Vec3){
+      0.5f * (h.bbox_min[0] + h.bbox_max[0]),
+      0.5f * (h.bbox_min[1] + h.bbox_max[1]),
+      0.5f * (h.bbox_min[2] + h.bbox_max[2])
+    };
+    mesh->quant_scale = (Vec3){h.quant_scale[0], h.quant_scale[1], h.quant_scale[2]};
+  }
+  if (h.header_size >= offsetof(MeshHeader, centroid) + sizeof(h.centroid) && h.sphere[3] >= 0.0f) {
+    mesh->has_sphere = true;
+    mesh->sphere_center = (Vec3){h.sphere[0], h.sphere[1], h.sphere[2]};
+    mesh->sphere_radius = h.sphere[3];
+    mesh->centroid = (Vec3){h.centroid[0], h.centroid[1], h.centroid[2]};
+  }
+  return true;
+}
+
+bool mesh_open(Mesh *mesh, const void *data, size_t size) {
+  memset(mesh, 0, sizeof(*mesh));
+  if (!data || size < 8) return false;
+  mesh->data = data;
+  mesh->end = (const uint8_t *)data + size;
+  if (memcmp(data, MESH_MAGIC, 4) == 0) {
+    return open_v2(mesh, data, size);
+  }
+  return open_v1(mesh, data, size);
+}
+
+int mesh_bundle_count(const void *data, size_t size) {
+  MeshBundleHeader h;
+  if (!data || size < sizeof(h)) return 0;
+  memcpy(&h, data, sizeof(h));
+  if (memcmp(h.magic, MESH_BUNDLE_MAGIC, 4) != 0 || h.version != MESH_BUNDLE_VERSION) return 0;
+  if (!in_bounds(size, sizeof(h), (uint64_t)h.nb_models * sizeof(MeshBundleEntry))) return 0;
+  return h.nb_models;
+}
+
+bool mesh_bundle_entry(const void *data, size_t size, int index, MeshBundleEntry *entry) {
+  if (index < 0 || index >= mesh_bundle_count(data, size)) return false;
+  memcpy(entry, (const uint8_t *)data + sizeof(MeshBundleHeader) + index * sizeof(MeshBundleEntry), sizeof(*entry));
+  entry->name[MESH_BUNDLE_NAME - 1] = '\0';
+  return entry->size > 0 && in_bounds(size, entry->offset, entry->size);
+}
+
+bool mesh_open_lod(const Mesh *mesh, int lod, Mesh *out) {
+  if (lod < 1 || lod > mesh->nb_lods) return false;
+  uint32_t offset = mesh_u32(mesh->lods + (lod - 1) * 8);
+  uint32_t size = mesh_u32(mesh->lods + (lod - 1) * 8 + 4);
+  if (!in_bounds(mesh->end - mesh->data, offset, size)) return false;
+  return mesh_open(out, mesh->data + offset, size) && out->version == 2 && out->nb_lods == 0;
+}
+
+void mesh_read_points(const Mesh *mesh, int first, int count, Vec3 *out) {
+  if (!(mesh->flags & MESH_FLAG_QUANTIZED)) {
+    memcpy(out, mesh->points + first * sizeof(float[3]), count * sizeof(float[3]));
+    return;
+  }
+  const uint8_t *src = mesh->points + first * sizeof(int16_t[3]);
+  Vec3 c = mesh->quant_center, s = mesh->quant_scale;
+  for (int i = 0; i < count; i++) {
+    int16_t q[3];
+    memcpy(q, src + i * sizeof(q), sizeof(q));
+    out[i] = (Vec3){c.x + q[0] * s.x, c.y + q[1] * s.y, c.z + q[2] * s.z};
+  }
+}
+
+Vec3 mesh_point(const Mesh *mesh, int index) {
+  Vec3 p;
+  mesh_read_points(mesh, index, 1, &p);
+  return p;
+}
+
+void mesh_bounds(const Mesh *mesh, Vec3 *bbox_min, Vec3 *bbox_max) {
+  if (mesh->has_bounds) {
+    *bbox_min = mesh->bbox_min;
+    *bbox_max = mesh->bbox_max;
+    return;
+  }
+  *bbox_min = *bbox_max = (Vec3){0.0f, 0.0f, 0.0f};
+  for (int i = 0; i < mesh->nb_points; i++) {
+    Vec3 p = mesh_point(mesh, i);
+    if (i == 0) *bbox_min = *bbox_max = p;
+    if (p.x < bbox_min->x) bbox_min->x = p.x;
+    if (p.y < bbox_min->y) bbox_min->y = p.y;
+    if (p.z < bbox_min->z) bbox_min->z = p.z;
+    if (p.x > bbox_max->x) bbox_max->x = p.x;
+    if (p.y > bbox_max->y) bbox_max->y = p.y;
+    if (p.z > bbox_max->z) bbox_max->z = p.z;
+  }
+}
+
+bool mesh_sphere(const Mesh *mesh, Vec3 *center, float *radius) {
+  Vec3 c, d;
+  float r;
+  if (mesh->has_sphere) {
+    c = mesh->sphere_center;
+    r = mesh->sphere_radius;
+    *center = mesh->centroid;
+  } else if (mesh->has_bounds) {
+    // Models converted before the sphere: the box and its half diagonal
+    c = *center = (Vec3){0.5f * (mesh->bbox_min.x + mesh->bbox_max.x), 0.5f * (mesh->bbox_min.y + mesh->bbox_max.y),
+                         0.5f * (mesh->bbox_min.z + mesh->bbox_max.z)};
+    d = (Vec3){mesh->bbox_max.x - c.x, mesh->bbox_max.y - c.y, mesh->bbox_max.z - c.z};
+    r = sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+  } else {
+    return false;
+  }
+  // The centroid is inside the sphere, the sphere around it is bigger by
+  // their distance
+  d = (Vec3){center->x - c.x, center->y - c.y, center->z - c.z};
+  *radius = r + sqrtf(d.x * d.x + d.y * d.y + d.z * d.z);
+  return true;
+}
+
+void mesh_chunk_edges(const Mesh *mesh, int chunk, EdgeReader *reader) {
+  uint32_t begin = mesh_u32(mesh->chunks + chunk * sizeof(uint32_t));
+  uint32_t end = mesh_u32(mesh->chunks + (chunk + 1) * sizeof(uint32_t));
+  bool edges16 = mesh->flags & MESH_FLAG_EDGES16;
+  if (mesh->strips) {
+    reader->encoding = EDGES_STRIP16;
+    reader->p = mesh->edges + mesh_u32(mesh->strips + chunk * sizeof(uint32_t)) * sizeof(uint16_t);
+    reader->end = mesh->edges + mesh_u32(mesh->strips + (chunk + 1) * sizeof(uint32_t)) * sizeof(uint16_t);
+  } else {
+    reader->encoding = edges16 ? EDGES_UINT16 : EDGES_INT32;
+    reader->p = mesh->edges + begin * (edges16 ? sizeof(uint16_t[2]) : sizeof(int32_t[2]));
+    reader->end = mesh->end;
+  }
+  reader->remaining = end - begin;
+  reader->base = edges16 ? chunk * mesh->chunk_points : 0;
+  reader->index = begin;
+  reader->strip_left = 0;
+}
+
+void mesh_cross_edges(const Mesh *mesh, EdgeReader *reader) {
+  if (mesh->flags & MESH_FLAG_CROSS_VARINT) {
+    reader->encoding = EDGES_VARINT;
+  } else if (mesh->strips) {
+    reader->encoding = EDGES_STRIP16;
+  } else {
+    reader->encoding = (mesh->flags & MESH_FLAG_EDGES16) ? EDGES_UINT16 : EDGES_INT32;
+  }
+  reader->p = mesh->cross_edges;
+  reader->end = mesh->end;
+  reader->remaining = mesh->nb_cross_edges;
+  reader->base = 0;
+  reader->index = mesh->nb_edges - mesh->nb_cross_edges;
+  reader->strip_left = 0;
+}
+
+void mesh_all_edges(const Mesh *mesh, EdgeReader *reader) {
+  reader->encoding = EDGES_INT32;
+  reader->p = mesh->edges;
+  reader->end = mesh->end;
+  reader->remaining = mesh->nb_edges;
+  reader->base = 0;
+  reader->index = 0;
+  reader->strip_left = 0;
+}
+
+void mesh_chunk_box(const Mesh *mesh, int chunk, Vec3 *bbox_min, Vec3 *bbox_max) {
+  int16_t q[6];
+  memcpy(q, mesh->boxes + chunk * sizeof(q), sizeof(q));
+  Vec3 c = mesh->quant_center, s = mesh->quant_scale;
+  *bbox_min = (Vec3){c.x + q[0] * s.x, c.y + q[1] * s.y, c.z + q[2] * s.z};
+  *bbox_max = (Vec3){c.x + q[3] * s.x, c.y + q[4] * s.y, c.z + q[5] * s.z};
+}
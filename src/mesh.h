@@ -0,0 +1,292 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "vec3.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Binary model formats, everything is little-endian.
+//
+// v1: int32 nb_points, int32 nb_edges, nb_points x float32[3], nb_edges x int32[2]
+//
+// v2: MeshHeader, then the sections at the offsets given by the header.
+// Vertices are split in chunks of chunk_points consecutive vertices. The
+// edges whose two ends are in the same chunk are stored bucketed by chunk,
+// the chunk table (nb_chunks + 1 uint32) gives the first edge of each
+// bucket. The remaining edges are stored in the cross edge list.
+// Edges are sorted by their lower end, the lower end comes first.
+//
+// header_size lets new fields be appended: a field is present when it
+// fits in header_size.
+//
+// Coarser levels of detail are complete v2 meshes without LOD of their own,
+// stored after the main one. The LOD table (nb_lods x uint32 offset, uint32
+// size, from the start of the file) lists them from finest to coarsest.
+//
+// Faces (optional, nb_faces > 0): nb_faces x {int8 normal[3] * 127, uint8
+// nb_triangles, float32 offset}, the viewpoint v is in front of the face
+// when dot(normal, v) >= offset. The adjacency table gives the two faces of each
+// edge, nb_edges x uint16[2] in the stored edge order (chunk edges, then
+// cross edges), MESH_NO_FACE for none. The triangles (nb_triangles x
+// uint16[3] vertex indices, needs nb_points <= 65536) are the fans of the
+// faces, in face order: each face has nb_triangles of them.
+//
+// Edge strips (MESH_FLAG_STRIPS): the edges are chained, each strip is a
+// uint16 number of vertices (at least 2) then its uint16 vertex indices, and
+// every two consecutive vertices make an edge, in this order. The strip table
+// (nb_chunks + 1 uint32) gives the first uint16 of the strips of each chunk
+// in the chunk edge section; the chunk table still counts edges. The stored
+// edge order is the order along the strips, ends are in any order.
+//
+// Chunk boxes (optional, quantized models only): nb_chunks x int16 min[3],
+// max[3], the bounding box of the quantized vertices of each chunk.
+//
+// Bounding sphere: the center of the bounding box and the distance to its
+// farthest vertex, then the centroid, the mean of the vertices. The app
+// frames the model from them without reading a vertex.
+//
+// Bundle: several models in one file, MeshBundleHeader then nb_models x
+// MeshBundleEntry, then the models (v1 or v2) at the offsets of their
+// entries, from the start of the bundle. The entries are read without
+// opening the models.
+#define MESH_MAGIC "3DVB"
+#define MESH_VERSION 2
+
+// Vertices are int16[3], position = bbox center + q * quant_scale
+#define MESH_FLAG_QUANTIZED 0x1
+// Chunk edges are uint16[2] relative to the first vertex of their chunk,
+// cross edges are uint16[2] too (needs nb_points <= 65536)
+#define MESH_FLAG_EDGES16 0x2
+// Cross edges are varints: lower end minus the previous lower end, then
+// upper end minus lower end
+#define MESH_FLAG_CROSS_VARINT 0x4
+// Chunk edges are strips of chunk relative indices, cross edges are strips
+// of vertex indices unless they are varints (needs MESH_FLAG_EDGES16)
+#define MESH_FLAG_STRIPS 0x8
+
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t header_size;
+  uint32_t flags;
+  uint32_t nb_points;
+  uint32_t nb_edges;        // chunk edges + cross edges
+  uint32_t chunk_points;
+  uint32_t nb_chunks;
+  uint32_t points_offset;
+  uint32_t chunks_offset;   // (nb_chunks + 1) x uint32
+  uint32_t edges_offset;    // chunk edges
+  uint32_t nb_cross_edges;
+  uint32_t cross_offset;
+  float bbox_min[3];
+  float bbox_max[3];
+  float quant_scale[3];
+  uint32_t nb_lods;
+  uint32_t lods_offset;
+  uint32_t nb_faces;        // < MESH_NO_FACE
+  uint32_t faces_offset;
+  uint32_t adjacency_offset;
+  uint32_t nb_triangles;
+  uint32_t triangles_offset;
+  uint32_t strips_offset;   // (nb_chunks + 1) x uint32
+  uint32_t boxes_offset;    // nb_chunks x int16[6]
+  float sphere[4];          // center, radius
+  float centroid[3];
+} MeshHeader;
+
+#define MESH_BUNDLE_MAGIC "3DVP"
+#define MESH_BUNDLE_VERSION 1
+#define MESH_BUNDLE_NAME 24
+
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t nb_models;
+} MeshBundleHeader;
+
+typedef struct {
+  char name[MESH_BUNDLE_NAME];   // NUL padded, at most MESH_BUNDLE_NAME - 1 bytes
+  uint32_t offset;
+  uint32_t size;
+  uint16_t version;        // of the model format
+  uint16_t reserved;
+  float bbox_min[3];       // 0 when unknown
+  float bbox_max[3];
+} MeshBundleEntry;
+
+#define MESH_HEADER_BASE_SIZE offsetof(MeshHeader, bbox_min)
+#define MESH_MAX_LODS 3
+#define MESH_NO_FACE 0xFFFF
+
+enum {
+  EDGES_INT32,
+  EDGES_UINT16,
+  EDGES_VARINT,
+  EDGES_STRIP16
+};
+
+typedef struct {
+  int version;
+  uint32_t flags;
+  const uint8_t *data;
+  int nb_points;
+  int nb_edges;
+  const uint8_t *points;
+  const uint8_t *edges;
+  const uint8_t *end;
+  bool has_bounds;
+  Vec3 bbox_min, bbox_max;
+  bool has_sphere;
+  Vec3 sphere_center, centroid;
+  float sphere_radius;
+  Vec3 quant_center, quant_scale;
+  // v2 only
+  int chunk_points;
+  int nb_chunks;
+  const uint8_t *chunks;
+  const uint8_t *strips;
+  const uint8_t *boxes;
+  int nb_cross_edges;
+  const uint8_t *cross_edges;
+  int nb_lods;
+  const uint8_t *lods;
+  int nb_faces;
+  const uint8_t *faces;
+  const uint8_t *adjacency;
+  int nb_triangles;
+  const uint8_t *triangles;
+} Mesh;
+
+// Sequential reader over an edge list, whatever its encoding
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+  int remaining;
+  int encoding;
+  int base;
+  int index;   // of the next edge in the stored order
+  int previous;     // strips: end of the last edge
+  int strip_left;   // strips: edges left in the current strip
+} EdgeReader;
+
+// False when a table does not fit the data, or when a face of the adjacency
+// or a vertex of a triangle is out of range
+bool mesh_open(Mesh *mesh, const void *data, size_t size);
+// Opens the coarser level of detail lod (1 to nb_lods)
+bool mesh_open_lod(const Mesh *mesh, int lod, Mesh *out);
+// Number of models of a bundle, 0 when the data is not one or when its
+// entries do not fit in it
+int mesh_bundle_count(const void *data, size_t size);
+// Entry of model index, false when the model is not inside the data
+bool mesh_bundle_entry(const void *data, size_t size, int index, MeshBundleEntry *entry);
+void mesh_read_points(const Mesh *mesh, int first, int count, Vec3 *out);
+Vec3 mesh_point(const Mesh *mesh, int index);
+// Bounding box from the header, or from the vertices when it has none
+void mesh_bounds(const Mesh *mesh, Vec3 *bbox_min, Vec3 *bbox_max);
+// Point to turn around, the centroid, and the radius of a sphere around it
+// holding every vertex, from the header only. False for v1 models.
+bool mesh_sphere(const Mesh *mesh, Vec3 *center, float *radius);
+void mesh_chunk_edges(const Mesh *mesh, int chunk, EdgeReader *reader);
+void mesh_cross_edges(const Mesh *mesh, EdgeReader *reader);
+void mesh_all_edges(const Mesh *mesh, EdgeReader *reader);
+// Bounding box of the vertices of the chunk, needs mesh->boxes
+void mesh_chunk_box(const Mesh *mesh, int chunk, Vec3 *bbox_min, Vec3 *bbox_max);
+
+static inline uint32_t mesh_u32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline int8_t mesh_face_normal(const Mesh *mesh, int face, int axis) {
+  return (int8_t)mesh->faces[face * 8 + axis];
+}
+
+static inline int mesh_face_triangles(const Mesh *mesh, int face) {
+  return mesh->faces[face * 8 + 3];
+}
+
+static inline float mesh_face_offset(const Mesh *mesh, int face) {
+  float offset;
+  memcpy(&offset, mesh->faces + face * 8 + 4, sizeof(offset));
+  return offset;
+}
+
+// Faces of the edge with this index in the stored order
+static inline void mesh_edge_faces(const Mesh *mesh, int edge, int *f0, int *f1) {
+  uint16_t f[2];
+  memcpy(f, mesh->adjacency + edge * sizeof(f), sizeof(f));
+  *f0 = f[0];
+  *f1 = f[1];
+}
+
+static inline void mesh_triangle(const Mesh *mesh, int triangle, int *v) {
+  uint16_t t[3];
+  memcpy(t, mesh->triangles + triangle * sizeof(t), sizeof(t));
+  v[0] = t[0];
+  v[1] = t[1];
+  v[2] = t[2];
+}
+
+static inline uint32_t edge_varint(EdgeReader *r) {
+  uint32_t v = 0;
+  for (int shift = 0; r->p < r->end && shift < 32; shift += 7) {
+    uint8_t byte = *r->p++;
+    v |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) break;
+  }
+  return v;
+}
+
+static inline bool edge_strip_next(EdgeReader *r, int *a, int *b) {
+  uint16_t v[2];
+  if (r->strip_left == 0) {
+    // Next strip: its number of vertices, then its first vertex
+    if (r->end - r->p < 4) return false;
+    memcpy(v, r->p, sizeof(v));
+    r->p += sizeof(v);
+    if (v[0] < 2) return false;
+    r->strip_left = v[0] - 1;
+    r->previous = r->base + v[1];
+  }
+  if (r->end - r->p < 2) return false;
+  memcpy(v, r->p, sizeof(v[0]));
+  r->p += sizeof(v[0]);
+  r->strip_left--;
+  *a = r->previous;
+  *b = r->previous = r->base + v[0];
+  return true;
+}
+
+static inline bool edge_next(EdgeReader *r, int *a, int *b) {
+  if (r->remaining <= 0) return false;
+  r->remaining--;
+  r->index++;
+  if (r->encoding == EDGES_STRIP16) {
+    if (!edge_strip_next(r, a, b)) {
+      r->remaining = 0;
+      return false;
+    }
+  } else if (r->encoding == EDGES_UINT16) {
+    uint16_t e[2];
+    memcpy(e, r->p, sizeof(e));
+    r->p += sizeof(e);
+    *a = r->base + e[0];
+    *b = r->base + e[1];
+  } else if (r->encoding == EDGES_INT32) {
+    int32_t e[2];
+    memcpy(e, r->p, sizeof(e));
+    r->p += sizeof(e);
+    *a = e[0];
+    *b = e[1];
+  } else {
+    r->base += edge_varint(r);
+    *a = r->base;
+    *b = r->base + edge_varint(r);
+  }
+  return true;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "profile.h"
+#include "eadk.h"
+#include <stdio.h>
+#include <string.h>
+
+// The host build reads a real clock, its eadk_timing_millis is fake
+#ifndef PROFILE_CLOCK_US
+#define PROFILE_CLOCK_US() (eadk_timing_millis() * 1000)
+#endif
+
+bool profile_enabled = false;
+ProfileCounts profile_counts;
+
+static const char *const stage_names[PROFILE_STAGES] = {
+  "other", "clear", "transform", "edges", "depth/fill", "push"
+};
+
+// Microseconds of each stage, and of the whole frame last, per frame
+static uint32_t history[PROFILE_STAGES + 1][PROFILE_FRAMES];
+static int nb_frames, next_frame;
+static uint32_t spent[PROFILE_STAGES];
+static uint64_t frame_start, last_switch;
+static int current = PROFILE_OTHER;
+static ProfileCounts last_counts;
+
+void profile_reset() {
+  nb_frames = 0;
+  next_frame = 0;
+  last_counts = (ProfileCounts){0, 0, 0};
+}
+
+void profile_begin_frame() {
+  profile_counts = (ProfileCounts){0, 0, 0};
+  current = PROFILE_OTHER;
+  if (!profile_enabled) return;
+  memset(spent, 0, sizeof(spent));
+  frame_start = last_switch = PROFILE_CLOCK_US();
+}
+
+int profile_enter(int stage) {
+  int left = current;
+  current = stage;
+  if (!profile_enabled) return left;
+  uint64_t now = PROFILE_CLOCK_US();
+  spent[left] += (uint32_t)(now - last_switch);
+  last_switch = now;
+  return left;
+}
+
+void profile_end_frame() {
+  if (!profile_enabled) return;
+  profile_enter(PROFILE_OTHER);
+  for (int s = 0; s < PROFILE_STAGES; s++) history[s][next_frame] = spent[s];
+  history[PROFILE_STAGES][next_frame] = (uint32_t)(last_switch - frame_start);
+  next_frame = (next_frame + 1) % PROFILE_FRAMES;
+  if (nb_frames < PROFILE_FRAMES) nb_frames++;
+  last_counts = profile_counts;
+}
+
+// Hundredths of a millisecond
+#define FMT_MS(us) (unsigned)((us) / 1000), (unsigned)((us) / 10 % 100)
+
+int profile_format(char *buf, size_t size) {
+  int lines = 0;
+  size_t len = 0;
+  buf[0] = '\0';
+  len += snprintf(buf + len, size - len, "Profile, last %2d frames, ms min    avg    max", nb_frames);
+  lines++;
+  for (int s = 0; s <= PROFILE_STAGES && len < size; s++) {
+    uint32_t low = UINT32_MAX, high = 0;
+    uint64_t sum = 0;
+    for (int f = 0; f < nb_frames; f++) {
+      uint32_t us = history[s][f];
+      if (us < low) low = us;
+      if (us > high) high = us;
+      sum += us;
+    }
+    if (nb_frames == 0) low = 0;
+    uint32_t avg = nb_frames ? (uint32_t)(sum / nb_frames) : 0;
+    len += snprintf(buf + len, size - len, "\n%-25s%3u.%02u %3u.%02u %3u.%02u",
+                    s < PROFILE_STAGES ? stage_names[s] : "frame", FMT_MS(low), FMT_MS(avg), FMT_MS(high));
+    lines++;
+  }
+  if (len < size) {
+    snprintf(buf + len, size - len, "\nVertices %u, edges %u, px %u",
+             (unsigned)last_counts.vertices, (unsigned)last_counts.edges, (unsigned)last_counts.pixels);
+    lines++;
+  }
+  return lines;
+}
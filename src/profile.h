@@ -0,0 +1,48 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Time of each stage of render_frame over the last PROFILE_FRAMES frames.
+// Stages are exclusive: entering one charges the time since the last switch
+// to the stage being left.
+//
+// The device clock counts milliseconds, a stage shorter than that reads 0
+// or 1 ms, but a tick falls in it with a probability of its duration, so the
+// averages stay right. The host build reads a microsecond clock.
+#define PROFILE_FRAMES 32
+
+enum {
+  PROFILE_OTHER,       // the rest of render_frame: setup, back faces
+  PROFILE_CLEAR,       // framebuffer or screen clear
+  PROFILE_TRANSFORM,   // transform and projection of whole batches or chunks
+  PROFILE_EDGES,       // edge scan, culling, clipping and rasterization
+  PROFILE_DEPTH,       // depth buffer or filled triangles
+  PROFILE_PUSH,        // framebuffer to screen
+  PROFILE_STAGES
+};
+
+typedef struct {
+  uint32_t vertices;   // projected
+  uint32_t edges;      // sent to the clipper
+  uint32_t pixels;     // pushed to the screen
+} ProfileCounts;
+
+extern bool profile_enabled;
+// Of the frame being drawn, render.c adds to them
+extern ProfileCounts profile_counts;
+
+// Forgets every frame
+void profile_reset();
+void profile_begin_frame();
+void profile_end_frame();
+// Switches to the stage, returns the one left
+int profile_enter(int stage);
+// Table of min, avg and max ms per stage and of the whole frame, then the
+// counts of the last frame, at most 45 characters per line. Returns the
+// number of lines.
+int profile_format(char *buf, size_t size);
+
+#endif
@@ -0,0 +1,86 @@
+import argparse
+import os
+import struct
+import sys
+
+from obj2bin import MAGIC, VERSION, pad4
+
+# Keep in sync with src/mesh.h
+BUNDLE_MAGIC = b'3DVP'
+BUNDLE_VERSION = 1
+BUNDLE_HEADER_FORMAT = '<4sHH'
+ENTRY_FORMAT = '<24sIIHH3f3f'
+NAME_SIZE = 24
+# Offset and end of bbox_min, bbox_max in the v2 header
+BOUNDS_FIELD = struct.calcsize('<4sHHIIIIIIIIII')
+BOUNDS_END = BOUNDS_FIELD + struct.calcsize('<3f3f')
+
+class BundleError(Exception):
+    pass
+
+def model_info(data):
+    # Format version and bounding box of a .bin model, from the v2 header or
+    # from the vertices of a v1 model
+    if data[:4] == MAGIC:
+        version, header_size = struct.unpack_from('<HH', data, 4)
+        if version != VERSION:
+            raise BundleError(f'format version {version}, convert it again')
+        if header_size < BOUNDS_END:
+            return version, (0.0,) * 3, (0.0,) * 3
+        bounds = struct.unpack_from('<3f3f', data, BOUNDS_FIELD)
+        return version, bounds[:3], bounds[3:]
+    if len(data) < 8:
+        raise BundleError('not a model')
+    nb_points, nb_edges = struct.unpack_from('<ii', data)
+    if nb_points < 0 or nb_edges < 0 or 8 + 12 * nb_points + 8 * nb_edges > len(data):
+        raise BundleError('not a model')
+    if nb_points == 0:
+        return 1, (0.0,) * 3, (0.0,) * 3
+    coords = struct.unpack_from(f'<{3 * nb_points}f', data, 8)
+    return 1, tuple(min(coords[i::3]) for i in range(3)), tuple(max(coords[i::3]) for i in range(3))
+
+def model_name(path):
+    # File name without its extension, cut to fit the entry with its NUL
+    name = os.path.splitext(os.path.basename(path))[0].encode('utf-8')[:NAME_SIZE - 1]
+    return name.decode('utf-8', errors='ignore').encode('utf-8')
+
+def write_bundle(paths, outname):
+    models = []
+    for path in paths:
+        with open(path, 'rb') as f:
+            data = f.read()
+        try:
+            version, bbox_min, bbox_max = model_info(data)
+        except BundleError as e:
+            raise BundleError(f'{path}: {e}')
+        models.append((model_name(path), version, bbox_min, bbox_max, pad4(bytearray(data)), len(data)))
+
+    # Models start on 4 byte boundaries after the entries
+    offset = struct.calcsize(BUNDLE_HEADER_FORMAT) + len(models) * struct.calcsize(ENTRY_FORMAT)
+    table = bytearray(struct.pack(BUNDLE_HEADER_FORMAT, BUNDLE_MAGIC, BUNDLE_VERSION, len(models)))
+    for name, version, bbox_min, bbox_max, data, size in models:
+        table += struct.pack(ENTRY_FORMAT, name, offset, size, version, 0, *bbox_min, *bbox_max)
+        offset += len(data)
+    with open(outname, 'wb') as f:
+        f.write(table)
+        for model in models:
+            f.write(model[4])
+
+def main():
+    parser = argparse.ArgumentParser(description='Packs .bin models into one bundle, the app lists them at startup.')
+    parser.add_argument('output', help='bundle to write')
+    parser.add_argument('inputs', nargs='+', help='.bin models, named after their file')
+    parser.add_argument('-q', '--quiet', action='store_true', help='no summary')
+    args = parser.parse_args()
+    if len(args.inputs) > 0xFFFF:
+        parser.error('at most 65535 models')
+
+    try:
+        write_bundle(args.inputs, args.output)
+    except (OSError, BundleError) as e:
+        sys.exit(str(e))
+    if not args.quiet:
+        print(f'{args.output}: {len(args.inputs)} models, {os.path.getsize(args.output)} bytes', file=sys.stderr)
+
+if __name__ == '__main__':
+    main()
@@ -1,28 +1,485 @@
-import struct
-
-def parse_obj(filename):
-    points = []
-    edges = set()
-    with open(filename) as f:
-        for line in f:
-            if line.startswith('v '):
-                _, x, y, z = line.split()
-                points.append((float(x), float(y), float(z)))
-            elif line.startswith('f '):
-                idx = [int(part.split('/')[0]) - 1 for part in line.split()[1:]]
-                for i in range(len(idx)):
-                    a, b = idx[i], idx[(i+1)%len(idx)]
-                    edge = tuple(sorted((a, b)))
-                    edges.add(edge)
-    return points, list(edges)
-
-def write_bin(points, edges, outname):
-    with open(outname, 'wb') as f:
-        f.write(struct.pack('<ii', len(points), len(edges)))
-        for x, y, z in points:
-            f.write(struct.pack('<fff', x, y, z))
-        for a, b in edges:
-            f.write(struct.pack('<ii', a, b))
-
-points, edges = parse_obj('moto.obj')
-write_bin(points, edges, 'monfichier.bin')
+import argparse
+import math
+import os
+import struct
+import sys
+import time
+
+# Keep in sync with src/mesh.h
+MAGIC = b'3DVB'
+VERSION = 2
+HEADER_FORMAT = '<4sHHIIIIIIIIII3f3f3fIIIIIIIII4f3f'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+FLAG_QUANTIZED = 0x1
+FLAG_EDGES16 = 0x2
+FLAG_CROSS_VARINT = 0x4
+FLAG_STRIPS = 0x8
+# Offset of nb_lods, lods_offset in the header
+LODS_FIELD = struct.calcsize('<4sHHIIIIIIIIII3f3f3f')
+CHUNK_POINTS = 512
+# Coarser levels target nb_points / ratio vertices, models with fewer edges get none
+LOD_RATIOS = (4, 16)
+LOD_MIN_EDGES = 2000
+LOD_MIN_POINTS = 64
+# Face indices are uint16 in the adjacency table, bigger models get no faces
+NO_FACE = 0xFFFF
+MAX_FACES = NO_FACE * LOD_RATIOS[-1]
+# Cells per axis of the vertex order curve
+MORTON_BITS = 10
+
+class ObjError(Exception):
+    pass
+
+def obj_index(token, nb_points, line_number):
+    # 1-based, negative counts back from the last vertex read, v/vt/vn keeps v
+    try:
+        i = int(token.split('/', 1)[0])
+    except ValueError:
+        raise ObjError(f'line {line_number}: bad vertex index {token!r}')
+    i = i + nb_points if i < 0 else i - 1
+    if i < 0:
+        raise ObjError(f'line {line_number}: vertex index {token} out of range')
+    return i
+
+def parse_obj(filename):
+    # Streams the lines. Edges are deduplicated as int keys, lower end << 32
+    # | upper end, far smaller than tuples. Faces past MAX_FACES are dropped:
+    # even the coarsest level would have too many to store them.
+    points = []
+    keys = set()
+    faces = []
+    nb_faces = 0
+    highest = -1
+    with open(filename, encoding='utf-8', errors='replace') as f:
+        for line_number, line in enumerate(f, 1):
+            parts = line.split()
+            if not parts:
+                continue
+            tag = parts[0]
+            if tag == 'v':
+                if len(parts) < 4:
+                    raise ObjError(f'line {line_number}: vertex with less than 3 coordinates')
+                points.append((float(parts[1]), float(parts[2]), float(parts[3])))
+            elif tag == 'f' or tag == 'l':
+                idx = [obj_index(part, len(points), line_number) for part in parts[1:]]
+                highest = max(highest, *idx) if idx else highest
+                # Faces are closed, polylines are not
+                count = len(idx) if tag == 'f' else len(idx) - 1
+                for i in range(count):
+                    a, b = idx[i], idx[(i + 1) % len(idx)]
+                    keys.add(a << 32 | b if a < b else b << 32 | a)
+                if tag == 'f':
+                    nb_faces += 1
+                    if nb_faces <= MAX_FACES:
+                        faces.append(tuple(idx))
+    if highest >= len(points):
+        raise ObjError(f'vertex index {highest + 1} out of range, {len(points)} vertices')
+    if nb_faces > MAX_FACES:
+        faces = []
+    edges = [(k >> 32, k & 0xFFFFFFFF) for k in sorted(keys)]
+    return points, edges, faces
+
+def spread(v):
+    # Bit i of v at bit 3i
+    out = 0
+    for bit in range(MORTON_BITS):
+        out |= (v >> bit & 1) << (3 * bit)
+    return out
+
+SPREAD = [spread(v) for v in range(1 << MORTON_BITS)]
+
+def reorder(points, edges, faces=(), chunk_points=CHUNK_POINTS):
+    # Vertices along a Morton curve over the bounding box, so that the
+    # vertices of a chunk are close in space and most edges stay inside one.
+    # Ties keep the OBJ order, faces keep their winding. Modelers often write
+    # connected vertices next to each other already: the OBJ order stays when
+    # the curve does not leave fewer edges across chunks.
+    if not points:
+        return points, edges, faces
+    bbox_min = [min(p[i] for p in points) for i in range(3)]
+    extent = [(max(p[i] for p in points) - bbox_min[i]) or 1.0 for i in range(3)]
+    last = (1 << MORTON_BITS) - 1
+    codes = [SPREAD[int((p[0] - bbox_min[0]) / extent[0] * last)] |
+             SPREAD[int((p[1] - bbox_min[1]) / extent[1] * last)] << 1 |
+             SPREAD[int((p[2] - bbox_min[2]) / extent[2] * last)] << 2 for p in points]
+    order = sorted(range(len(points)), key=codes.__getitem__)
+    remap = [0] * len(points)
+    for new, old in enumerate(order):
+        remap[old] = new
+    curve_edges = sorted((min(remap[a], remap[b]), max(remap[a], remap[b])) for a, b in edges)
+    if locality(curve_edges, chunk_points)[1] >= locality(edges, chunk_points)[1]:
+        return points, edges, faces
+    return [points[i] for i in order], curve_edges, [tuple(remap[i] for i in face) for face in faces]
+
+def locality(edges, chunk_points=CHUNK_POINTS):
+    # Mean index distance between the ends of the edges, and share of the
+    # edges across two chunks, which are read and projected one by one
+    if not edges:
+        return 0.0, 0.0
+    span = sum(b - a for a, b in edges) / len(edges)
+    cross = sum(a // chunk_points != b // chunk_points for a, b in edges) / len(edges)
+    return span, cross
+
+def edge_strips(edges):
+    # Greedy cover of the edges by chains, each edge once: a chain starts at
+    # the lowest vertex with an odd number of edges left, then at the lowest
+    # with any, and goes on to the lowest neighbor left
+    neighbors = {}
+    for a, b in edges:
+        neighbors.setdefault(a, []).append(b)
+        neighbors.setdefault(b, []).append(a)
+    for n in neighbors.values():
+        n.sort()
+    left = {v: len(n) for v, n in neighbors.items()}
+    first = dict.fromkeys(neighbors, 0)
+    used = set()
+
+    def walk(v):
+        strip = [v]
+        # The number of vertices is a uint16
+        while len(strip) < 0xFFFF:
+            n = neighbors[v]
+            i = first[v]
+            while i < len(n) and (min(v, n[i]), max(v, n[i])) in used:
+                i += 1
+            first[v] = i
+            if i == len(n):
+                break
+            w = n[i]
+            used.add((min(v, w), max(v, w)))
+            left[v] -= 1
+            left[w] -= 1
+            strip.append(w)
+            v = w
+        return strip
+
+    strips = []
+    for odd in (True, False):
+        for v in sorted(neighbors):
+            while left[v] > 0 and (left[v] % 2 == 1 or not odd):
+                strips.append(walk(v))
+    return strips
+
+def encode_strips(strips, base):
+    return b''.join(struct.pack(f'<{len(s) + 1}H', len(s), *(v - base for v in s)) for s in strips)
+
+def bucket_edges(nb_points, edges, chunk_points):
+    # Edges inside one chunk go to its bucket, the others to the cross list
+    nb_chunks = (nb_points + chunk_points - 1) // chunk_points
+    buckets = [[] for _ in range(nb_chunks)]
+    cross = []
+    for a, b in sorted(edges):
+        if a // chunk_points == b // chunk_points:
+            buckets[a // chunk_points].append((a, b))
+        else:
+            cross.append((a, b))
+    return buckets, cross
+
+def f32(x):
+    return struct.unpack('<f', struct.pack('<f', x))[0]
+
+def quantize(points):
+    # int16 positions around the bounding box center, same float32 math as mesh.c
+    bbox_min = [f32(min(p[i] for p in points)) if points else 0.0 for i in range(3)]
+    bbox_max = [f32(max(p[i] for p in points)) if points else 0.0 for i in range(3)]
+    center = [f32(f32(bbox_min[i] + bbox_max[i]) * 0.5) for i in range(3)]
+    scale = [f32((bbox_max[i] - bbox_min[i]) / 65534) or 1.0 for i in range(3)]
+    quantized = [tuple(max(-32767, min(32767, math.floor((p[i] - center[i]) / scale[i] + 0.5))) for i in range(3))
+                 for p in points]
+    return quantized, bbox_min, bbox_max, scale, center
+
+def bounding_sphere(points, center):
+    # Sphere around the bounding box center through the farthest vertex, and
+    # the mean of the vertices. Plain sums, in the order of the JS converter.
+    if not points:
+        return [0.0] * 4, [0.0] * 3
+    far = 0.0
+    total = [0.0, 0.0, 0.0]
+    for p in points:
+        dx, dy, dz = p[0] - center[0], p[1] - center[1], p[2] - center[2]
+        d = dx * dx + dy * dy + dz * dz
+        if d > far:
+            far = d
+        for i in range(3):
+            total[i] += p[i]
+    return [*center, f32(math.sqrt(far))], [f32(t / len(points)) for t in total]
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+def pad4(data):
+    return data + bytes(-len(data) % 4)
+
+def face_normal(points, face):
+    # Newell's method, works for non planar polygons too
+    n = [0.0, 0.0, 0.0]
+    for i in range(len(face)):
+        p, q = points[face[i]], points[face[(i + 1) % len(face)]]
+        n[0] += (p[1] - q[1]) * (p[2] + q[2])
+        n[1] += (p[2] - q[2]) * (p[0] + q[0])
+        n[2] += (p[0] - q[0]) * (p[1] + q[1])
+    length = math.sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2])
+    return [n[i] / length if length > 0 else 0.0 for i in range(3)]
+
+def encode_faces(points, faces):
+    # int8 normal * 127, number of triangles, float32 plane offset: the
+    # viewpoint v sees the front of the face when dot(normal, v) >= offset
+    data = bytearray()
+    for face in faces:
+        q = [max(-127, min(127, math.floor(v * 127 + 0.5))) for v in face_normal(points, face)]
+        c = [sum(points[i][k] for i in face) / len(face) for k in range(3)]
+        offset = q[0] / 127 * c[0] + q[1] / 127 * c[1] + q[2] / 127 * c[2]
+        data += struct.pack('<bbbBf', *q, len(fan(face)), offset)
+    return bytes(data)
+
+def fan(face):
+    # Up to 255 triangles, their count is a byte
+    return [(face[0], face[i], face[i + 1]) for i in range(1, min(len(face) - 1, 256))]
+
+def triangles(faces):
+    # Fans of the faces in face order
+    return [t for face in faces for t in fan(face)]
+
+def edge_faces(faces):
+    # Edge -> its two faces, edges of one face or of more than two get none
+    adjacent = {}
+    for f, face in enumerate(faces):
+        for i in range(len(face)):
+            a, b = face[i], face[(i + 1) % len(face)]
+            adjacent.setdefault((min(a, b), max(a, b)), []).append(f)
+    return adjacent
+
+def encode_mesh(points, edges, chunk_points=CHUNK_POINTS, faces=(), strips=True):
+    # v2 mesh with no LOD, offsets relative to its start
+    buckets, cross = bucket_edges(len(points), edges, chunk_points)
+    nb_chunks = len(buckets)
+    quantized, bbox_min, bbox_max, scale, center = quantize(points)
+    sphere, centroid = bounding_sphere(points, center)
+    flags = FLAG_QUANTIZED | FLAG_EDGES16
+    if len(points) > 65536:
+        flags |= FLAG_CROSS_VARINT
+    if strips:
+        flags |= FLAG_STRIPS
+
+    points_data = pad4(b''.join(struct.pack('<hhh', *q) for q in quantized))
+    # Bounding box of the quantized vertices of each chunk
+    boxes_data = bytearray()
+    for first in range(0, len(quantized), chunk_points):
+        chunk = quantized[first:first + chunk_points]
+        boxes_data += struct.pack('<6h', *(min(q[i] for q in chunk) for i in range(3)),
+                                  *(max(q[i] for q in chunk) for i in range(3)))
+    chunks_data = bytearray()
+    strips_data = bytearray()
+    edges_data = bytearray()
+    first = 0
+    for chunk, bucket in enumerate(buckets):
+        chunks_data += struct.pack('<I', first)
+        first += len(bucket)
+        base = chunk * chunk_points
+        if strips:
+            # The stored edge order is the order along the strips
+            chains = edge_strips(bucket)
+            buckets[chunk] = [(s[i], s[i + 1]) for s in chains for i in range(len(s) - 1)]
+            strips_data += struct.pack('<I', len(edges_data) // 2)
+            edges_data += encode_strips(chains, base)
+        else:
+            for a, b in bucket:
+                edges_data += struct.pack('<HH', a - base, b - base)
+    chunks_data += struct.pack('<I', first)
+    if strips:
+        strips_data += struct.pack('<I', len(edges_data) // 2)
+    edges_data = pad4(edges_data)
+    if flags & FLAG_CROSS_VARINT:
+        cross_data = bytearray()
+        previous = 0
+        for a, b in cross:
+            cross_data += varint(a - previous) + varint(b - a)
+            previous = a
+    elif strips:
+        chains = edge_strips(cross)
+        cross = [(s[i], s[i + 1]) for s in chains for i in range(len(s) - 1)]
+        cross_data = encode_strips(chains, 0)
+    else:
+        cross_data = b''.join(struct.pack('<HH', a, b) for a, b in cross)
+
+    faces_data = b''
+    adjacency_data = bytearray()
+    triangles_data = b''
+    if faces and len(faces) < NO_FACE:
+        faces_data = encode_faces(points, faces)
+        adjacent = edge_faces(faces)
+        # Same order as the stored edges: chunk buckets, then cross edges
+        for edge in [e for bucket in buckets for e in bucket] + cross:
+            f = adjacent.get((min(edge), max(edge)), [])
+            f0 = f[0] if 1 <= len(f) <= 2 else NO_FACE
+            f1 = f[1] if len(f) == 2 else NO_FACE
+            adjacency_data += struct.pack('<HH', f0, f1)
+        if len(points) <= 65536:
+            triangles_data = pad4(b''.join(struct.pack('<HHH', *t) for t in triangles(faces)))
+    else:
+        faces = ()
+
+    points_offset = HEADER_SIZE
+    chunks_offset = points_offset + len(points_data)
+    boxes_offset = chunks_offset + len(chunks_data)
+    strips_offset = boxes_offset + len(boxes_data)
+    edges_offset = strips_offset + len(strips_data)
+    cross_offset = edges_offset + len(edges_data)
+    cross_data = pad4(cross_data)
+    faces_offset = cross_offset + len(cross_data)
+    adjacency_offset = faces_offset + len(faces_data)
+    triangles_offset = adjacency_offset + len(adjacency_data)
+    header = struct.pack(HEADER_FORMAT, MAGIC, VERSION, HEADER_SIZE, flags,
+                         len(points), len(edges), chunk_points, nb_chunks,
+                         points_offset, chunks_offset, edges_offset,
+                         len(cross), cross_offset,
+                         *bbox_min, *bbox_max, *scale, 0, 0,
+                         len(faces), faces_offset if faces else 0, adjacency_offset if faces else 0,
+                         len(triangles_data) // 6, triangles_offset if triangles_data else 0,
+                         strips_offset if strips else 0, boxes_offset if boxes_data else 0, *sphere, *centroid)
+    return bytearray(header + points_data + chunks_data + boxes_data + strips_data + edges_data + cross_data + faces_data + adjacency_data +
+                     triangles_data)
+
+def cell_keys(points, cells):
+    bbox_min = [min(p[i] for p in points) for i in range(3)]
+    extent = [(max(p[i] for p in points) - bbox_min[i]) or 1.0 for i in range(3)]
+    return [tuple(min(cells - 1, int((p[i] - bbox_min[i]) / extent[i] * cells)) for i in range(3))
+            for p in points]
+
+def cluster(points, edges, faces, cells):
+    # Vertex clustering: the vertices of each grid cell merge into their mean,
+    # clusters are numbered in order of their first vertex. Faces keep their
+    # distinct clusters, the ones left with less than 3 are dropped.
+    ids = {}
+    remap = []
+    sums = []
+    for key, p in zip(cell_keys(points, cells), points):
+        if key not in ids:
+            ids[key] = len(sums)
+            sums.append([0.0, 0.0, 0.0, 0])
+        c = ids[key]
+        remap.append(c)
+        s = sums[c]
+        s[0] += p[0]
+        s[1] += p[1]
+        s[2] += p[2]
+        s[3] += 1
+    lod_points = [(s[0] / s[3], s[1] / s[3], s[2] / s[3]) for s in sums]
+    lod_edges = set()
+    for a, b in edges:
+        a, b = remap[a], remap[b]
+        if a != b:
+            lod_edges.add((min(a, b), max(a, b)))
+    lod_faces = []
+    seen = set()
+    for face in faces:
+        lod_face = []
+        for i in face:
+            if remap[i] not in lod_face:
+                lod_face.append(remap[i])
+        key = tuple(sorted(lod_face))
+        if len(lod_face) >= 3 and key not in seen:
+            seen.add(key)
+            lod_faces.append(tuple(lod_face))
+    return lod_points, list(lod_edges), lod_faces
+
+def build_lods(points, edges, faces=()):
+    # Finest grid whose cluster count stays under each target
+    lods = []
+    if len(edges) < LOD_MIN_EDGES:
+        return lods
+    for ratio in LOD_RATIOS:
+        target = len(points) // ratio
+        if target < LOD_MIN_POINTS:
+            break
+        low, high = 1, 1024
+        while low < high:
+            cells = (low + high + 1) // 2
+            if len(set(cell_keys(points, cells))) <= target:
+                low = cells
+            else:
+                high = cells - 1
+        lod = cluster(points, edges, faces, low)
+        previous = lods[-1][1] if lods else edges
+        if len(lod[1]) > 0.75 * len(previous):
+            break
+        lods.append(lod)
+    return lods
+
+def write_bin(points, edges, outname, chunk_points=CHUNK_POINTS, lods=True, faces=(), strips=True):
+    data = pad4(encode_mesh(points, edges, chunk_points, faces, strips))
+    levels = [pad4(encode_mesh(p, e, chunk_points, f, strips)) for p, e, f in build_lods(points, edges, faces)] if lods else []
+    if levels:
+        # LOD table (offset, size) then the coarser meshes, finest first
+        lods_offset = len(data)
+        struct.pack_into('<II', data, LODS_FIELD, len(levels), lods_offset)
+        offset = lods_offset + 8 * len(levels)
+        table = bytearray()
+        for level in levels:
+            table += struct.pack('<II', offset, len(level))
+            offset += len(level)
+        data += table + b''.join(levels)
+    with open(outname, 'wb') as f:
+        f.write(data)
+
+def write_bin_v1(points, edges, outname):
+    with open(outname, 'wb') as f:
+        f.write(struct.pack('<ii', len(points), len(edges)))
+        for x, y, z in points:
+            f.write(struct.pack('<fff', x, y, z))
+        for a, b in edges:
+            f.write(struct.pack('<ii', a, b))
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts a Wavefront .obj model to the .bin model of the app.')
+    parser.add_argument('input', nargs='?', default='moto.obj', help='.obj model (default: moto.obj)')
+    parser.add_argument('output', nargs='?', default='monfichier.bin', help='.bin model (default: monfichier.bin)')
+    parser.add_argument('--format', type=int, choices=(1, VERSION), default=VERSION,
+                        help='format version, 1 is vertices and edges only (default: %(default)s)')
+    parser.add_argument('--chunk-points', type=int, default=CHUNK_POINTS,
+                        help='vertices per chunk, at most 65536 (default: %(default)s)')
+    parser.add_argument('--no-lods', action='store_true', help='no coarser levels of detail')
+    parser.add_argument('--no-reorder', action='store_true',
+                        help='keep the OBJ vertex order, even when a Morton order has fewer edges across chunks')
+    parser.add_argument('--no-strips', action='store_true', help='edges as pairs of vertices instead of strips')
+    parser.add_argument('--no-faces', action='store_true', help='no faces, culling and filled modes get nothing')
+    parser.add_argument('-q', '--quiet', action='store_true', help='no summary')
+    args = parser.parse_args()
+    if not 1 <= args.chunk_points <= 65536:
+        parser.error('--chunk-points must be between 1 and 65536')
+
+    start = time.perf_counter()
+    try:
+        points, edges, faces = parse_obj(args.input)
+    except (OSError, ObjError, ValueError) as e:
+        sys.exit(f'{args.input}: {e}')
+    parsed = time.perf_counter()
+    if not args.no_reorder:
+        points, edges, faces = reorder(points, edges, faces, args.chunk_points)
+    if args.format == 1:
+        write_bin_v1(points, edges, args.output)
+    else:
+        write_bin(points, edges, args.output, args.chunk_points, not args.no_lods, () if args.no_faces else faces,
+                  not args.no_strips)
+    end = time.perf_counter()
+
+    if not args.quiet:
+        megabytes = os.path.getsize(args.input) / 1e6
+        print(f'{args.output}: {len(points)} vertices, {len(edges)} edges, {len(faces)} faces, '
+              f'{os.path.getsize(args.output)} bytes', file=sys.stderr)
+        print(f'parsed {megabytes:.1f} MB in {parsed - start:.2f} s ({megabytes / max(parsed - start, 1e-9):.1f} MB/s, '
+              f'{len(points) / max(parsed - start, 1e-9) / 1e3:.0f}k vertices/s), '
+              f'written in {end - parsed:.2f} s', file=sys.stderr)
+        span, cross = locality(edges, args.chunk_points)
+        print(f'edges: mean index span {span:.0f}, {cross * 100:.1f}% across chunks', file=sys.stderr)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,870 @@
+#include "render.h"
+#include "clip.h"
+#include "depth.h"
+#include "fill.h"
+#include "framebuffer.h"
+#include "profile.h"
+#include "transform.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool use_framebuffer = false;
+int cull_mode = CULL_NONE;
+bool hidden_lines = false;
+bool filled = false;
+bool antialias = false;
+bool (*render_poll)() = NULL;
+int render_slice_edges = RENDER_SLICE_EDGES;
+PushStats push_stats;
+EdgeStats edge_stats;
+TriangleStats triangle_stats;
+
+// Faces meeting at more than 45 degrees make a crease: n0.n1 < cos(45) * 127^2
+#define CREASE_DOT 11405
+
+// Bounding box of the per-pixel path, drawn this frame and on screen
+typedef struct {
+  int x0, y0, x1, y1;   // empty when x1 < x0
+} Box;
+
+static Box drawn_box, shown_box;
+static bool full_clear = true;
+
+// Progressive frame: the next slice ends when edge_stats.edges reaches next
+static struct {
+  uint32_t next;
+  bool stopped;
+} slice;
+
+// Batch buffers, allocated once by render_init
+static struct {
+  void *block;
+  int batch_points;
+  int (*projected)[2];
+  Vec3 *points;   // kept points of a float model that is one batch, else NULL
+  float *depths;   // 1/W of each vertex, hidden line mode only
+  uint8_t *back_faces;   // one bit per face of the mesh, set when it faces away
+  int nb_faces;
+  uint8_t *kept_chunks;   // one bit per chunk, set when its points are kept
+  int nb_kept;            // chunks the bits can hold
+  uint8_t *inks;          // filled mode only, palette index of each face, two per byte
+} arena;
+
+// The float path keeps the (X / W, Y / W, 1 / W) of a model that is one
+// batch in arena.points: while the camera only zooms or moves across the
+// view, the next frames reproject them in 2D (see project_kept). v1 models
+// are one chunk.
+static struct {
+  const uint8_t *data;   // of the mesh, NULL when nothing is kept
+  Camera base;        // the points were transformed by
+} kept;
+
+static void box_add(Box *box, int x, int y) {
+  if (x < box->x0) box->x0 = x;
+  if (x > box->x1) box->x1 = x;
+  if (y < box->y0) box->y0 = y;
+  if (y > box->y1) box->y1 = y;
+}
+
+// Pushes the pixels from (x0, y0) to (x1, y1), a row or a column
+static void push_run(int x0, int y0, int x1, int y1, eadk_color_t color) {
+  eadk_rect_t rect = {x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, abs(x1 - x0) + 1, abs(y1 - y0) + 1};
+  eadk_display_push_rect_uniform(rect, color);
+  push_stats.pixels += rect.width * rect.height;
+  push_stats.calls++;
+}
+
+// The pixels of the major axis that share their minor coordinate are one
+// push, a flat line is a few runs instead of a push per pixel
+void draw_line(int x0, int y0, int x1, int y1, eadk_color_t color) {
+  int dx = abs(x1 - x0), dy = abs(y1 - y0);
+  int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+  int err = dx - dy;
+  int run_x = x0, run_y = y0;
+  while (x0 != x1 || y0 != y1) {
+    int e2 = 2 * err;
+    int x = x0, y = y0;
+    if (e2 > -dy) { err -= dy; x += sx; }
+    if (e2 < dx) { err += dx; y += sy; }
+    if (dx >= dy ? y != y0 : x != x0) {
+      push_run(run_x, run_y, x0, y0, color);
+      run_x = x;
+      run_y = y;
+    }
+    x0 = x;
+    y0 = y;
+  }
+  push_run(run_x, run_y, x0, y0, color);
+}
+
+// Shows the frame so far and asks render_poll whether to go on
+static bool slice_end() {
+  if (slice.stopped) return true;
+  int stage = profile_enter(PROFILE_PUSH);
+  if (use_framebuffer) {
+    fb_flush();
+    push_stats.pixels += fb.pushed_pixels;
+    push_stats.calls += fb.push_calls;
+  }
+  profile_enter(stage);
+  slice.stopped = render_poll();
+  slice.next = slice.stopped ? 0 : edge_stats.edges + render_slice_edges;
+  return slice.stopped;
+}
+
+// Bits of the indices below n
+static int spread_bits(int n) {
+  int bits = 0;
+  while ((1 << bits) < n) bits++;
+  return bits;
+}
+
+// Index i with its bits reversed: every prefix of the order is spread over
+// the whole range, the indices past the range are skipped by the caller
+static int spread(int i, int bits) {
+  int r = 0;
+  for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+  return r;
+}
+
+typedef struct {
+  const Mesh *mesh;
+  const Camera *cam;
+  bool fixed;   // project straight from the int16 vertices
+  FixedView fixed_view;
+  const uint8_t *back_faces;   // NULL when every edge is drawn
+  bool depth_test;   // hidden line mode, the depth buffer is ready
+  bool projected;    // the whole model is already projected in the arena
+  bool cull_chunks;  // the chunks have boxes to test against planes
+  bool keep;         // projections go through the kept points
+  float planes[5][4];  // of the view, inside when a * p + d >= 0
+} Frame;
+
+// depths may be NULL
+static void project_points(const Frame *frame, int first, int count, int (*projected)[2], float *depths) {
+  profile_counts.vertices += count;
+  if (FIXED_POINT && frame->fixed) {
+    const uint8_t *q = frame->mesh->points + first * sizeof(int16_t[3]);
+    transform_mesh_fixed(&frame->fixed_view, q, count, projected, depths);
+    return;
+  }
+  transform_mesh(frame->cam, frame->mesh, first, count, projected, depths);
+}
+
+// project_points of whole chunks of a model kept in arena.points
+static void project_keep(const Frame *frame, int first, int count, int (*projected)[2], float *depths) {
+  const Mesh *mesh = frame->mesh;
+  int unit = mesh->version >= 2 ? mesh->chunk_points : mesh->nb_points;
+  bool moved = memcmp(frame->cam, &kept.base, sizeof(Camera)) != 0;
+  profile_counts.vertices += count;
+  for (int chunk = first / unit; chunk * unit < first + count; chunk++) {
+    int start = chunk * unit, n = start + unit < mesh->nb_points ? unit : mesh->nb_points - start;
+    Vec3 *points = arena.points + start;
+    int (*out)[2] = projected + (start - first);
+    if (!(arena.kept_chunks[chunk >> 3] & (1 << (chunk & 7)))) {
+      mesh_read_points(mesh, start, n, points);
+      transform_and_project_keep(&kept.base, points, n, out);
+      arena.kept_chunks[chunk >> 3] |= 1 << (chunk & 7);
+      if (moved) project_kept(frame->cam, &kept.base, points, n, out);
+    } else {
+      project_kept(frame->cam, &kept.base, points, n, out);
+    }
+    if (!depths) continue;
+    for (int i = 0; i < n; i++) depths[start - first + i] = points[i].z > 0.0f ? points[i].z : 1.0f / CAMERA_NEAR;
+  }
+}
+
+// project_points of a batch or a chunk, timed by the profiler. Single
+// vertices are not, the clock would cost more than them.
+static void project_batch(const Frame *frame, int first, int count, int (*projected)[2], float *depths) {
+  int stage = profile_enter(PROFILE_TRANSFORM);
+  if (frame->keep) {
+    project_keep(frame, first, count, projected, depths);
+  } else {
+    project_points(frame, first, count, projected, depths);
+  }
+  profile_enter(stage);
+}
+
+// Near plane and the four sides of the screen, a pixel out, as world planes
+static void find_planes(const Camera *cam, float planes[5][4]) {
+  const float (*v)[4] = cam->view;
+  float half_w = WIDTH / 2 + 1, half_h = HEIGHT / 2 + 1;
+  for (int k = 0; k < 4; k++) {
+    planes[0][k] = v[2][k];
+    planes[1][k] = half_w * v[2][k] + v[0][k];
+    planes[2][k] = half_w * v[2][k] - v[0][k];
+    planes[3][k] = half_h * v[2][k] + v[1][k];
+    planes[4][k] = half_h * v[2][k] - v[1][k];
+  }
+  planes[0][3] -= CAMERA_NEAR;
+}
+
+// Whether the vertices of the chunk are all off one side of the view
+static bool chunk_outside(const Frame *frame, int chunk) {
+  Vec3 lo, hi;
+  mesh_chunk_box(frame->mesh, chunk, &lo, &hi);
+  Vec3 c = {0.5f * (lo.x + hi.x), 0.5f * (lo.y + hi.y), 0.5f * (lo.z + hi.z)};
+  Vec3 e = {0.5f * (hi.x - lo.x), 0.5f * (hi.y - lo.y), 0.5f * (hi.z - lo.z)};
+  for (int i = 0; i < 5; i++) {
+    const float *p = frame->planes[i];
+    float d = p[0] * c.x + p[1] * c.y + p[2] * c.z + p[3];
+    float r = fabsf(p[0]) * e.x + fabsf(p[1]) * e.y + fabsf(p[2]) * e.z;
+    if (d + r < 0.0f) return true;
+  }
+  return false;
+}
+
+// Sets the bit of the faces the viewpoint is behind
+static void find_back_faces(const Mesh *mesh, const Camera *cam, uint8_t *back_faces) {
+  Vec3 v = cam->viewpoint;
+  memset(back_faces, 0, (mesh->nb_faces + 7) / 8);
+  for (int f = 0; f < mesh->nb_faces; f++) {
+    float d = mesh_face_normal(mesh, f, 0) * v.x + mesh_face_normal(mesh, f, 1) * v.y + mesh_face_normal(mesh, f, 2) * v.z;
+    if (d < mesh_face_offset(mesh, f) * 127.0f) back_faces[f >> 3] |= 1 << (f & 7);
+  }
+}
+
+static bool is_back(const Frame *frame, int face) {
+  return frame->back_faces[face >> 3] & (1 << (face & 7));
+}
+
+// Whether the edge with this index is hidden by the cull mode
+static bool edge_culled(const Frame *frame, int edge) {
+  if (!frame->back_faces) return false;
+  int f0, f1;
+  mesh_edge_faces(frame->mesh, edge, &f0, &f1);
+  if (f0 == MESH_NO_FACE) return false;
+
+  bool culled;
+  if (f1 == MESH_NO_FACE) {
+    // Border of the surface
+    culled = is_back(frame, f0);
+  } else if (cull_mode == CULL_BACK) {
+    culled = is_back(frame, f0) && is_back(frame, f1);
+  } else if (is_back(frame, f0) != is_back(frame, f1)) {
+    culled = false;   // silhouette
+  } else {
+    const Mesh *mesh = frame->mesh;
+    int dot = 0;
+    for (int axis = 0; axis < 3; axis++) dot += mesh_face_normal(mesh, f0, axis) * mesh_face_normal(mesh, f1, axis);
+    culled = is_back(frame, f0) || dot >= CREASE_DOT;
+  }
+  edge_stats.culled += culled;
+  return culled;
+}
+
+// Both ends must be on screen
+static void raster_line(int x0, int y0, int x1, int y1) {
+  if (use_framebuffer && antialias) {
+    fb_draw_line_aa(x0, y0, x1, y1, FB_INK);
+  } else if (use_framebuffer) {
+    fb_draw_line(x0, y0, x1, y1, FB_INK);
+  } else {
+    box_add(&drawn_box, x0, y0);
+    box_add(&drawn_box, x1, y1);
+    draw_line(x0, y0, x1, y1, eadk_color_black);
+  }
+}
+
+// 1/W at p of the segment q0-q1 whose ends are at z0 and z1
+static float depth_along(const int *q0, const int *q1, float z0, float z1, const int *p) {
+  int axis = abs(q1[0] - q0[0]) >= abs(q1[1] - q0[1]) ? 0 : 1;
+  if (q1[axis] == q0[axis]) return z0;
+  return z0 + (z1 - z0) * ((float)(p[axis] - q0[axis]) / (float)(q1[axis] - q0[axis]));
+}
+
+// Draws the runs of pixels of p0-p1 that pass the depth test, the depths
+// are interpolated along the unclipped segment q0-q1
+static void draw_visible(const int *q0, const int *q1, float z0, float z1, const int *p0, const int *p1) {
+  float z = depth_along(q0, q1, z0, z1, p0);
+  int x = p0[0], y = p0[1], x1 = p1[0], y1 = p1[1];
+  int dx = abs(x1 - x), dy = abs(y1 - y);
+  int sx = x < x1 ? 1 : -1, sy = y < y1 ? 1 : -1;
+  int err = dx - dy;
+  float dz = (dx > dy ? dx : dy) ? (depth_along(q0, q1, z0, z1, p1) - z) / (dx > dy ? dx : dy) : 0.0f;
+
+  int run_x = 0, run_y = 0, last_x = 0, last_y = 0;
+  bool in_run = false;
+  while (true) {
+    if (depth_visible(x, y, depth_value(z))) {
+      if (!in_run) {
+        run_x = x;
+        run_y = y;
+        in_run = true;
+      }
+      last_x = x;
+      last_y = y;
+    } else if (in_run) {
+      raster_line(run_x, run_y, last_x, last_y);
+      in_run = false;
+    }
+    if (x == x1 && y == y1) break;
+    int e2 = 2 * err;
+    if (e2 > -dy) { err -= dy; x += sx; }
+    if (e2 < dx) { err += dx; y += sy; }
+    z += dz;
+  }
+  if (in_run) raster_line(run_x, run_y, last_x, last_y);
+}
+
+// Draws the edge a-b, pa and pb are the projections of its ends and za, zb
+// their 1/W (hidden line mode)
+static void draw_edge(const Frame *frame, int a, int b, const int *pa, const int *pb, float za, float zb) {
+  edge_stats.edges++;
+  // The clippers and the rasters round by the way they go: an edge is drawn
+  // from its lower index, whichever way it is stored
+  if (a > b) {
+    int t = a; a = b; b = t;
+    const int *p = pa; pa = pb; pb = p;
+    float z = za; za = zb; zb = z;
+  }
+  int p0[2] = {pa[0], pa[1]}, p1[2] = {pb[0], pb[1]};
+  if (pa[0] == CLIP_BEHIND || pb[0] == CLIP_BEHIND) {
+    if (pa[0] == pb[0]) return;  // both behind
+    // Rare enough to go back to the float vertices
+    float c0[3], c1[3];
+    camera_transform(frame->cam, mesh_point(frame->mesh, a), c0);
+    camera_transform(frame->cam, mesh_point(frame->mesh, b), c1);
+    if (!clip_near(c0, c1, p0, p1)) return;
+    // The depths go along the clipped segment, the end behind is now on
+    // the near plane
+    za = 1.0f / (c0[2] > CAMERA_NEAR ? c0[2] : CAMERA_NEAR);
+    zb = 1.0f / (c1[2] > CAMERA_NEAR ? c1[2] : CAMERA_NEAR);
+  }
+  int q0[2] = {p0[0], p0[1]}, q1[2] = {p1[0], p1[1]};
+  if (!clip_segment(p0, p1)) return;
+
+  if (frame->depth_test) {
+    draw_visible(q0, q1, za, zb, p0, p1);
+  } else {
+    raster_line(p0[0], p0[1], p1[0], p1[1]);
+  }
+}
+
+// Draws the edges of the reader whose two ends are in the batch
+static void draw_edges(const Frame *frame, EdgeReader *reader, int (*projected)[2], int point_offset, int nb_points) {
+  int a, b;
+  while (edge_next(reader, &a, &b)) {
+    int i = a - point_offset, j = b - point_offset;
+    if (i >= 0 && i < nb_points && j >= 0 && j < nb_points && !edge_culled(frame, reader->index - 1)) {
+      float zi = frame->depth_test ? arena.depths[i] : 0.0f, zj = frame->depth_test ? arena.depths[j] : 0.0f;
+      draw_edge(frame, a, b, projected[i], projected[j], zi, zj);
+      if (edge_stats.edges >= slice.next && slice_end()) return;
+    }
+  }
+}
+
+static void screen_batch(
+  const Frame *frame,
+  int point_offset, int nb_points,
+  int (*projected)[2]
+) {
+  const Mesh *mesh = frame->mesh;
+  float *depths = frame->depth_test ? arena.depths : NULL;
+  bool cull = frame->cull_chunks && !frame->projected;
+  if (!frame->projected && !cull) project_batch(frame, point_offset, nb_points, projected, depths);
+
+  int stage = profile_enter(PROFILE_EDGES);
+  EdgeReader reader;
+  if (mesh->version >= 2) {
+    // v2 batches are made of whole chunks, drawn in spread order so that a
+    // stopped frame shows all over the model
+    int nb_chunks = (nb_points + mesh->chunk_points - 1) / mesh->chunk_points;
+    int bits = spread_bits(nb_chunks);
+    for (int i = 0; i < 1 << bits && !slice.stopped; i++) {
+      if (spread(i, bits) >= nb_chunks) continue;
+      int chunk = point_offset / mesh->chunk_points + spread(i, bits);
+      if (cull) {
+        // The edges of a chunk off the view are too, the others project
+        // their chunk only
+        if (chunk_outside(frame, chunk)) {
+          edge_stats.chunks_off++;
+          continue;
+        }
+        int first = chunk * mesh->chunk_points - point_offset;
+        int count = first + mesh->chunk_points < nb_points ? mesh->chunk_points : nb_points - first;
+        project_batch(frame, point_offset + first, count, projected + first, depths ? depths + first : NULL);
+      }
+      mesh_chunk_edges(mesh, chunk, &reader);
+      draw_edges(frame, &reader, projected, point_offset, nb_points);
+    }
+  } else {
+    // v1 has no edge index, every batch scans the whole edge table
+    mesh_all_edges(mesh, &reader);
+    draw_edges(frame, &reader, projected, point_offset, nb_points);
+  }
+  profile_enter(stage);
+}
+
+static void screen_edge(const Frame *frame, int a, int b) {
+  if (a < 0 || a >= frame->mesh->nb_points || b < 0 || b >= frame->mesh->nb_points) return;
+  int projected[2][2];
+  float depths[2];
+  project_points(frame, a, 1, &projected[0], frame->depth_test ? &depths[0] : NULL);
+  project_points(frame, b, 1, &projected[1], frame->depth_test ? &depths[1] : NULL);
+  draw_edge(frame, a, b, projected[0], projected[1], depths[0], depths[1]);
+}
+
+// Draws the edges of the reader projecting their ends one at a time. An edge
+// that starts where the last one ended reuses its projection: along strips
+// every vertex is projected once.
+static void draw_polyline(const Frame *frame, EdgeReader *reader) {
+  int nb_points = frame->mesh->nb_points;
+  int a, b, last = -1;
+  int pa[2], pb[2];
+  float za = 0.0f, zb = 0.0f;
+  while (edge_next(reader, &a, &b)) {
+    if (a < 0 || a >= nb_points || b < 0 || b >= nb_points || edge_culled(frame, reader->index - 1)) continue;
+    if (a == last) {
+      pa[0] = pb[0];
+      pa[1] = pb[1];
+      za = zb;
+    } else {
+      project_points(frame, a, 1, &pa, frame->depth_test ? &za : NULL);
+    }
+    project_points(frame, b, 1, &pb, frame->depth_test ? &zb : NULL);
+    draw_edge(frame, a, b, pa, pb, za, zb);
+    last = b;
+    if (edge_stats.edges >= slice.next && slice_end()) return;
+  }
+}
+
+// Triangle v of the mesh with a vertex behind the near plane, clipped like
+// the edges (see draw_edge) from the float vertices. Returns the number of
+// vertices of the polygon left, a fan of at most two triangles.
+static int clip_triangle(const Frame *frame, const int *v, int (*p)[2], float *z) {
+  float c[3][3];
+  for (int k = 0; k < 3; k++) camera_transform(frame->cam, mesh_point(frame->mesh, v[k]), c[k]);
+  return clip_near_triangle((const float (*)[3])c, p, z);
+}
+
+static void depth_triangle_of(const Frame *frame, const int *v, const int *p0, const int *p1, const int *p2,
+                              float z0, float z1, float z2) {
+  if (p0[0] == CLIP_BEHIND || p1[0] == CLIP_BEHIND || p2[0] == CLIP_BEHIND) {
+    if (p0[0] == CLIP_BEHIND && p1[0] == CLIP_BEHIND && p2[0] == CLIP_BEHIND) return;
+    int p[4][2];
+    float z[4];
+    int n = clip_triangle(frame, v, p, z);
+    for (int k = 2; k < n; k++) {
+      depth_triangle(p[0], p[k - 1], p[k], z[0], z[k - 1], z[k]);
+      triangle_stats.triangles++;
+    }
+    return;
+  }
+  depth_triangle(p0, p1, p2, z0, z1, z2);
+  triangle_stats.triangles++;
+}
+
+// Fills the depth buffer with the triangles of the model. Leaves the
+// projection of the whole model in the arena when it is one batch.
+static void depth_pass(const Frame *frame, int batch_points) {
+  const Mesh *mesh = frame->mesh;
+  uint32_t start = (uint32_t)eadk_timing_millis();
+  int stage = profile_enter(PROFILE_DEPTH);
+  triangle_stats.triangles = 0;
+
+  depth_clear();
+
+  for (int first = 0; first < mesh->nb_points; first += batch_points) {
+    int count = first + batch_points < mesh->nb_points ? batch_points : mesh->nb_points - first;
+    project_batch(frame, first, count, arena.projected, arena.depths);
+    for (int t = 0; t < mesh->nb_triangles; t++) {
+      int v[3];
+      mesh_triangle(mesh, t, v);
+      int i = v[0] - first, j = v[1] - first, k = v[2] - first;
+      if (i >= 0 && i < count && j >= 0 && j < count && k >= 0 && k < count) {
+        depth_triangle_of(frame, v, arena.projected[i], arena.projected[j], arena.projected[k],
+                          arena.depths[i], arena.depths[j], arena.depths[k]);
+      }
+    }
+  }
+
+  // Triangles across batches, one vertex at a time
+  if (mesh->nb_points > batch_points) {
+    for (int t = 0; t < mesh->nb_triangles; t++) {
+      int v[3];
+      mesh_triangle(mesh, t, v);
+      if (v[0] >= mesh->nb_points || v[1] >= mesh->nb_points || v[2] >= mesh->nb_points) continue;
+      if (v[0] / batch_points == v[1] / batch_points && v[1] / batch_points == v[2] / batch_points) continue;
+      int projected[3][2];
+      float depths[3];
+      for (int k = 0; k < 3; k++) project_points(frame, v[k], 1, &projected[k], &depths[k]);
+      depth_triangle_of(frame, v, projected[0], projected[1], projected[2], depths[0], depths[1], depths[2]);
+    }
+  }
+  profile_enter(stage);
+  triangle_stats.ms = (uint32_t)eadk_timing_millis() - start;
+}
+
+// Palette index of a face lit from the front left of the camera, both sides
+// alike: from 3 (facing the light) to 13
+static uint8_t face_ink(const Mesh *mesh, int face, Vec3 light) {
+  float d = (mesh_face_normal(mesh, face, 0) * light.x + mesh_face_normal(mesh, face, 1) * light.y +
+             mesh_face_normal(mesh, face, 2) * light.z) * (1.0f / 127.0f);
+  if (d < 0.0f) d = -d;
+  return 13 - (int)(d * 10.0f + 0.5f);
+}
+
+// face_ink of every face, the same in every band and batch of the frame
+static void find_inks(const Mesh *mesh, Vec3 light) {
+  memset(arena.inks, 0, (mesh->nb_faces + 1) / 2);
+  for (int f = 0; f < mesh->nb_faces; f++) arena.inks[f >> 1] |= face_ink(mesh, f, light) << ((f & 1) * 4);
+}
+
+static inline uint8_t ink_of(int face) {
+  return (arena.inks[face >> 1] >> ((face & 1) * 4)) & 0xF;
+}
+
+static void fill_of(const Frame *frame, const int *v, const int *p0, const int *p1, const int *p2,
+                    float z0, float z1, float z2, uint8_t ink) {
+  if (p0[0] == CLIP_BEHIND || p1[0] == CLIP_BEHIND || p2[0] == CLIP_BEHIND) {
+    if (p0[0] == CLIP_BEHIND && p1[0] == CLIP_BEHIND && p2[0] == CLIP_BEHIND) return;
+    int p[4][2];
+    float z[4];
+    int n = clip_triangle(frame, v, p, z);
+    for (int k = 2; k < n; k++) {
+      fill_triangle(p[0], p[k - 1], p[k], z[0], z[k - 1], z[k], ink);
+      triangle_stats.triangles++;
+    }
+    return;
+  }
+  fill_triangle(p0, p1, p2, z0, z1, z2, ink);
+  triangle_stats.triangles++;
+}
+
+// Screen rows of the batches in front of the camera, from the first band,
+// the next bands skip the batches they do not meet. A batch with a point
+// behind the near plane may reach any row once its triangles are clipped.
+#define FILL_MAX_BATCHES 64
+static int batch_rows[FILL_MAX_BATCHES][2];
+
+static void find_rows(int batch, int count) {
+  if (batch >= FILL_MAX_BATCHES) return;
+  int y0 = FB_HEIGHT, y1 = -1;
+  for (int i = 0; i < count; i++) {
+    if (arena.projected[i][0] == CLIP_BEHIND) {
+      y0 = 0;
+      y1 = FB_HEIGHT - 1;
+      break;
+    }
+    int y = arena.projected[i][1];
+    if (y < y0) y0 = y;
+    if (y > y1) y1 = y;
+  }
+  batch_rows[batch][0] = y0;
+  batch_rows[batch][1] = y1;
+}
+
+// Whether the triangle with vertices in these batches may meet the rows
+static bool rows_meet(const int *batches, int n, int y0, int y1) {
+  int low = INT32_MAX, high = INT32_MIN;
+  for (int k = 0; k < n; k++) {
+    if (batches[k] >= FILL_MAX_BATCHES) return true;
+    if (batch_rows[batches[k]][0] < low) low = batch_rows[batches[k]][0];
+    if (batch_rows[batches[k]][1] > high) high = batch_rows[batches[k]][1];
+  }
+  return low <= y1 && high >= y0;
+}
+
+// Fills the faces band by band, every band goes through the batches it
+// meets again unless the model is one batch
+static void fill_faces(const Frame *frame, int batch_points) {
+  const Mesh *mesh = frame->mesh;
+  const Camera *cam = frame->cam;
+  uint32_t start = (uint32_t)eadk_timing_millis();
+  int stage = profile_enter(PROFILE_DEPTH);
+  triangle_stats.triangles = 0;
+  bool one_batch = mesh->nb_points <= batch_points;
+
+  Vec3 light = {
+    cam->forward.x + 0.5f * cam->up.x - 0.5f * cam->right.x,
+    cam->forward.y + 0.5f * cam->up.y - 0.5f * cam->right.y,
+    cam->forward.z + 0.5f * cam->up.z - 0.5f * cam->right.z
+  };
+  float len = sqrtf(light.x * light.x + light.y * light.y + light.z * light.z);
+  light = (Vec3){light.x / len, light.y / len, light.z / len};
+  find_inks(mesh, light);
+
+  for (int y0 = 0; y0 < FB_HEIGHT; y0 += fb.strip_rows) {
+    int y1 = y0 + fb.strip_rows - 1;
+    fill_band(y0);
+    for (int first = 0; first < mesh->nb_points; first += batch_points) {
+      int count = first + batch_points < mesh->nb_points ? batch_points : mesh->nb_points - first;
+      int batch = first / batch_points;
+      if (y0 == 0) {
+        project_batch(frame, first, count, arena.projected, arena.depths);
+        find_rows(batch, count);
+      } else if (!rows_meet(&batch, 1, y0, y1)) {
+        continue;
+      } else if (!one_batch) {
+        project_batch(frame, first, count, arena.projected, arena.depths);
+      }
+      for (int f = 0, t = 0; f < mesh->nb_faces; f++) {
+        int n = mesh_face_triangles(mesh, f);
+        uint8_t ink = ink_of(f);
+        for (; n > 0; n--, t++) {
+          int v[3];
+          mesh_triangle(mesh, t, v);
+          int i = v[0] - first, j = v[1] - first, k = v[2] - first;
+          if (i >= 0 && i < count && j >= 0 && j < count && k >= 0 && k < count) {
+            fill_of(frame, v, arena.projected[i], arena.projected[j], arena.projected[k],
+                    arena.depths[i], arena.depths[j], arena.depths[k], ink);
+          }
+        }
+      }
+    }
+
+    // Triangles across batches, one vertex at a time
+    if (one_batch) continue;
+    for (int f = 0, t = 0; f < mesh->nb_faces; f++) {
+      int n = mesh_face_triangles(mesh, f);
+      uint8_t ink = ink_of(f);
+      for (; n > 0; n--, t++) {
+        int v[3];
+        mesh_triangle(mesh, t, v);
+        if (v[0] >= mesh->nb_points || v[1] >= mesh->nb_points || v[2] >= mesh->nb_points) continue;
+        int batches[3] = {v[0] / batch_points, v[1] / batch_points, v[2] / batch_points};
+        if (batches[0] == batches[1] && batches[1] == batches[2]) continue;
+        if (!rows_meet(batches, 3, y0, y1)) continue;
+        int projected[3][2];
+        float depths[3];
+        for (int k = 0; k < 3; k++) project_points(frame, v[k], 1, &projected[k], &depths[k]);
+        fill_of(frame, v, projected[0], projected[1], projected[2], depths[0], depths[1], depths[2], ink);
+      }
+    }
+  }
+  profile_enter(stage);
+  triangle_stats.ms = (uint32_t)eadk_timing_millis() - start;
+}
+
+static bool uses_fixed(const Mesh *mesh) {
+  return FIXED_POINT && (mesh->flags & MESH_FLAG_QUANTIZED);
+}
+
+bool render_init(const Mesh *mesh) {
+  free(arena.block);
+  arena.block = NULL;
+  kept.data = NULL;
+  // Culling works on the faces of the full model, the coarser levels have less
+  size_t faces_size = (mesh->nb_faces + 7) / 8;
+  int nb_kept = mesh->version >= 2 ? mesh->nb_chunks : 1;
+  faces_size += (nb_kept + 7) / 8;
+  if (filled) faces_size += (mesh->nb_faces + 1) / 2;
+
+  // v2 batches are made of whole chunks
+  int unit = mesh->version >= 2 ? mesh->chunk_points : 1;
+  int batch = (mesh->nb_points + unit - 1) / unit * unit;
+  if (batch == 0) batch = unit;
+  int min_points = mesh->version >= 2 ? unit : RENDER_MIN_BATCH;
+  if (min_points > batch) min_points = batch;
+  size_t depth_size = hidden_lines || filled ? sizeof(float) : 0;
+  // Only a model that is one batch keeps its points (see kept), the fixed
+  // point path projects straight from the model data
+  size_t keep_size = uses_fixed(mesh) ? 0 : sizeof(Vec3);
+
+  // Biggest batch that fits with RENDER_HEAP_RESERVE left for the rest,
+  // the whole model without its kept points before any smaller batch
+  while (true) {
+    size_t size = batch * (sizeof(int[2]) + depth_size + keep_size) + faces_size;
+    void *probe = malloc(size + RENDER_HEAP_RESERVE);
+    if (probe) {
+      free(probe);
+      arena.block = malloc(size);
+      if (arena.block) break;
+    }
+    if (keep_size) {
+      keep_size = 0;
+      continue;
+    }
+    if (batch <= min_points) return false;
+    int next = (batch / 2 + unit - 1) / unit * unit;
+    batch = next < min_points ? min_points : next;
+  }
+
+  uint8_t *at = arena.block;
+  arena.batch_points = batch;
+  arena.projected = (int (*)[2])at;
+  at += batch * sizeof(int[2]);
+  arena.depths = depth_size ? (float *)at : NULL;
+  at += batch * depth_size;
+  arena.points = keep_size ? (Vec3 *)at : NULL;
+  at += batch * keep_size;
+  arena.back_faces = at;
+  arena.nb_faces = mesh->nb_faces;
+  arena.kept_chunks = arena.back_faces + (mesh->nb_faces + 7) / 8;
+  arena.nb_kept = nb_kept;
+  arena.inks = filled ? arena.kept_chunks + (nb_kept + 7) / 8 : NULL;
+  return true;
+}
+
+bool render_set_hidden_lines(const Mesh *mesh, bool on) {
+  if (on == hidden_lines) return true;
+  // The depth buffer comes out of the batch buffers
+  free(arena.block);
+  arena.block = NULL;
+  if (on) {
+    hidden_lines = depth_init();
+    if (hidden_lines && render_init(mesh)) return true;
+    depth_free();
+    hidden_lines = false;
+    // Back to the buffers without it, render_fits tells whether they fit
+    render_init(mesh);
+    return false;
+  }
+  depth_free();
+  hidden_lines = false;
+  return render_init(mesh);
+}
+
+bool render_set_filled(const Mesh *mesh, bool on) {
+  if (on == filled) return true;
+  if (on && !fb.pixels) return false;
+  // The vertex depths come out of the batch buffers
+  filled = on;
+  if (render_init(mesh)) return true;
+  // Back to the buffers without them, render_fits tells whether they fit
+  filled = false;
+  if (on) render_init(mesh);
+  return false;
+}
+
+bool render_fits(const Mesh *mesh) {
+  if (!arena.block) return false;
+  return mesh->version < 2 || arena.batch_points >= mesh->chunk_points;
+}
+
+void screen_batches_dynamic(const Mesh *mesh, const Camera *cam) {
+  Frame frame = {.mesh = mesh, .cam = cam, .fixed = uses_fixed(mesh)};
+  if (frame.fixed) {
+    camera_fixed_view(cam, mesh->quant_center, mesh->quant_scale, &frame.fixed_view);
+  }
+  edge_stats = (EdgeStats){0, 0, 0};
+  if (mesh->boxes) {
+    find_planes(cam, frame.planes);
+    frame.cull_chunks = true;
+  }
+  if (cull_mode != CULL_NONE && mesh->nb_faces > 0 && mesh->nb_faces <= arena.nb_faces) {
+    find_back_faces(mesh, cam, arena.back_faces);
+    frame.back_faces = arena.back_faces;
+  }
+
+  int batch_points = arena.batch_points;
+  if (mesh->version >= 2) batch_points -= batch_points % mesh->chunk_points;
+  bool one_batch = mesh->nb_points <= batch_points;
+  if (one_batch && arena.points && !frame.fixed && (mesh->version < 2 || mesh->nb_chunks <= arena.nb_kept)) {
+    // A new view transforms the chunks again as they are drawn
+    if (kept.data != mesh->data || !camera_same_view(cam, &kept.base)) {
+      memset(arena.kept_chunks, 0, (arena.nb_kept + 7) / 8);
+      kept.data = mesh->data;
+      kept.base = *cam;
+    }
+    frame.keep = true;
+  }
+  if (filled && use_framebuffer && mesh->nb_triangles > 0 && mesh->nb_faces > 0 && mesh->nb_faces <= arena.nb_faces) {
+    fill_faces(&frame, batch_points);
+    return;
+  }
+  if (hidden_lines && mesh->nb_triangles > 0) {
+    depth_pass(&frame, batch_points);
+    frame.depth_test = true;
+    frame.projected = one_batch;
+  }
+  int nb_batches = (mesh->nb_points + batch_points - 1) / batch_points;
+  int bits = spread_bits(nb_batches);
+  for (int i = 0; i < 1 << bits && !slice.stopped; i++) {
+    if (spread(i, bits) >= nb_batches) continue;
+    int points_done = spread(i, bits) * batch_points;
+    int nb_points = (points_done + batch_points < mesh->nb_points) ? batch_points : (mesh->nb_points - points_done);
+    screen_batch(&frame, points_done, nb_points, arena.projected);
+  }
+  if (slice.stopped) {
+    profile_enter(PROFILE_OTHER);
+    return;
+  }
+
+  // Edges between two batches were skipped above, their ends are projected
+  // one at a time and charged to the edges
+  profile_enter(PROFILE_EDGES);
+  EdgeReader reader;
+  int a, b;
+  if (mesh->version >= 2) {
+    mesh_cross_edges(mesh, &reader);
+    if (one_batch && edge_stats.chunks_off == 0) {
+      // Every vertex is still projected
+      draw_edges(&frame, &reader, arena.projected, 0, mesh->nb_points);
+    } else {
+      draw_polyline(&frame, &reader);
+    }
+  } else if (!one_batch) {
+    mesh_all_edges(mesh, &reader);
+    while (edge_next(&reader, &a, &b)) {
+      if (a / batch_points != b / batch_points) {
+        screen_edge(&frame, a, b);
+        if (edge_stats.edges >= slice.next && slice_end()) break;
+      }
+    }
+  }
+  profile_enter(PROFILE_OTHER);
+}
+
+// Counts of the frame for the profiler, then commits it
+static void profile_frame_done() {
+  profile_counts.edges = edge_stats.edges;
+  profile_counts.pixels = push_stats.pixels;
+  profile_end_frame();
+}
+
+bool render_frame(const Mesh *mesh, const Camera *cam) {
+  profile_begin_frame();
+  slice.next = render_poll ? (uint32_t)render_slice_edges : UINT32_MAX;
+  slice.stopped = false;
+  if (use_framebuffer) {
+    profile_enter(PROFILE_CLEAR);
+    fb_clear();
+    profile_enter(PROFILE_OTHER);
+    push_stats = (PushStats){0, 0};
+    screen_batches_dynamic(mesh, cam);
+    profile_enter(PROFILE_PUSH);
+    fb_flush();
+    push_stats.pixels += fb.pushed_pixels;
+    push_stats.calls += fb.push_calls;
+    profile_frame_done();
+    return !slice.stopped;
+  }
+
+  // Single buffered: clear the last frame's box, then draw on screen
+  eadk_rect_t clear = eadk_screen_rect;
+  if (!full_clear) {
+    Box b = shown_box;
+    clear = (eadk_rect_t){b.x0, b.y0, b.x1 >= b.x0 ? b.x1 - b.x0 + 1 : 0, b.y1 - b.y0 + 1};
+  }
+  push_stats = (PushStats){0, 0};
+  profile_enter(PROFILE_CLEAR);
+  if (clear.width > 0) {
+    eadk_display_push_rect_uniform(clear, eadk_color_white);
+    push_stats = (PushStats){clear.width * clear.height, 1};
+  }
+  profile_enter(PROFILE_OTHER);
+  drawn_box = (Box){WIDTH, HEIGHT, -1, -1};
+  // The lines go straight to the screen, their push is in the edges
+  screen_batches_dynamic(mesh, cam);
+  shown_box = drawn_box;
+  full_clear = false;
+  profile_frame_done();
+  return !slice.stopped;
+}
+
+void render_invalidate() {
+  full_clear = true;
+  if (fb.pixels) fb_invalidate();
+}
+
+void render_overdrawn(eadk_rect_t rect) {
+  if (rect.width == 0 || rect.height == 0) return;
+  int x1 = rect.x + rect.width - 1, y1 = rect.y + rect.height - 1;
+  if (fb.pixels) fb_overdrawn(rect.x, rect.y, x1, y1);
+  box_add(&shown_box, rect.x, rect.y);
+  box_add(&shown_box, x1, y1);
+}
@@ -0,0 +1,95 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "camera.h"
+#include "mesh.h"
+#include "eadk.h"
+#include <stdbool.h>
+
+// Smallest v1 batch, v2 batches are at least one chunk
+#define RENDER_MIN_BATCH 64
+// Heap left free by render_init
+#define RENDER_HEAP_RESERVE 4096
+// Edges drawn between two calls of render_poll
+#define RENDER_SLICE_EDGES 65536
+
+extern bool use_framebuffer;
+
+// Edges drawn, from the faces of the model (others draw every edge)
+enum {
+  CULL_NONE,
+  CULL_BACK,      // not the edges between two back faces
+  CULL_OUTLINE,   // only the silhouette, crease and border edges
+  CULL_MODES
+};
+
+extern int cull_mode;
+// Hidden line mode: edges are depth tested against the triangles of the
+// model (see depth.h), set with render_set_hidden_lines
+extern bool hidden_lines;
+// Filled mode: flat shaded triangles instead of the edges, with the strip
+// framebuffer only, set with render_set_filled
+extern bool filled;
+// Anti-aliased lines, strip framebuffer only
+extern bool antialias;
+
+// Progressive rendering, when set: every render_slice_edges edges the
+// frame shows what it drew so far and calls render_poll, which returns true
+// to stop it (the camera is about to change). The depth pass and the filled
+// mode are not sliced.
+extern bool (*render_poll)();
+extern int render_slice_edges;
+
+typedef struct {
+  uint32_t pixels;   // pixels sent to the display
+  uint32_t calls;    // push_rect calls
+} PushStats;
+
+// Display traffic of the last render_frame
+extern PushStats push_stats;
+
+typedef struct {
+  uint32_t edges;    // edges sent to the clipper
+  uint32_t culled;   // edges culled from their faces
+  uint32_t chunks_off;   // chunks outside the view, not projected
+} EdgeStats;
+
+// Edges of the last render_frame
+extern EdgeStats edge_stats;
+
+typedef struct {
+  uint32_t triangles;   // rasterized, per band when filled
+  uint32_t ms;          // depth pass or fill time
+} TriangleStats;
+
+// Triangles of the last render_frame, hidden line or filled mode
+extern TriangleStats triangle_stats;
+
+// Both ends must be on screen (see clip.h)
+void draw_line(int x0, int y0, int x1, int y1, eadk_color_t color);
+// Allocates the batch buffers for the mesh, as many vertices per batch as
+// the heap allows. Returns false when not even the smallest batch fits.
+bool render_init(const Mesh *mesh);
+// Turns the hidden line mode on or off for this mesh, the depth buffer
+// shrinks the batch buffers. Returns false when it does not fit, the mode
+// is then unchanged. The batch buffers are allocated again either way: when
+// render_fits is false after it, not even those fit and nothing can be drawn.
+bool render_set_hidden_lines(const Mesh *mesh, bool on);
+// Turns the filled mode on or off for this mesh, it draws in the strip
+// framebuffer only. Returns false without one, or when the batch buffers do
+// not fit with the depth of the vertices, like render_set_hidden_lines.
+bool render_set_filled(const Mesh *mesh, bool on);
+// Whether the buffers of render_init can also draw this mesh (a coarser
+// level of detail of the same model)
+bool render_fits(const Mesh *mesh);
+void screen_batches_dynamic(const Mesh *mesh, const Camera *cam);
+// Only clears and pushes what changed since the last frame. Returns false
+// when render_poll stopped it, what was drawn is on screen.
+bool render_frame(const Mesh *mesh, const Camera *cam);
+// The screen was drawn over, the next frame repaints all of it
+void render_invalidate();
+// Something was drawn over the last frame in this rect (text overlays),
+// the next frame repaints it
+void render_overdrawn(eadk_rect_t rect);
+
+#endif
@@ -0,0 +1,121 @@
+#include "transform.h"
+#include "fixed.h"
+#include <string.h>
+
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#define TRANSFORM_DSP 1
+#else
+#define TRANSFORM_DSP 0
+#endif
+
+// Projection of a block of n vertices, X, Y and W of them all first, then
+// their divisions. Behind the near plane W is replaced by 1 before dividing
+// so that no lane sees an infinity.
+static void project_block(const Camera *cam, const float *x, const float *y, const float *z, int n,
+                          int (*projected)[2], float *depths) {
+  const float (*m)[4] = cam->view;
+  const float m00 = m[0][0], m01 = m[0][1], m02 = m[0][2], m03 = m[0][3];
+  const float m10 = m[1][0], m11 = m[1][1], m12 = m[1][2], m13 = m[1][3];
+  const float m20 = m[2][0], m21 = m[2][1], m22 = m[2][2], m23 = m[2][3];
+  float X[TRANSFORM_BLOCK], Y[TRANSFORM_BLOCK], W[TRANSFORM_BLOCK];
+  for (int i = 0; i < n; i++) {
+    X[i] = m00 * x[i] + m01 * y[i] + m02 * z[i] + m03;
+    Y[i] = m10 * x[i] + m11 * y[i] + m12 * z[i] + m13;
+    W[i] = m20 * x[i] + m21 * y[i] + m22 * z[i] + m23;
+  }
+  for (int i = 0; i < n; i++) {
+    bool behind = W[i] < CAMERA_NEAR;
+    float inv = 1.0f / (behind ? 1.0f : W[i]);
+    int px = camera_screen_coord(X[i] * inv + WIDTH / 2);
+    int py = camera_screen_coord(Y[i] * inv + HEIGHT / 2);
+    projected[i][0] = behind ? CLIP_BEHIND : px;
+    projected[i][1] = py;
+    W[i] = behind ? 1.0f / CAMERA_NEAR : inv;
+  }
+  if (depths) memcpy(depths, W, n * sizeof(float));
+}
+
+void transform_mesh(const Camera *cam, const Mesh *mesh, int first, int count, int (*projected)[2], float *depths) {
+  float x[TRANSFORM_BLOCK], y[TRANSFORM_BLOCK], z[TRANSFORM_BLOCK];
+  bool quantized = mesh->flags & MESH_FLAG_QUANTIZED;
+  const uint8_t *src = mesh->points + first * (quantized ? sizeof(int16_t[3]) : sizeof(float[3]));
+  Vec3 c = mesh->quant_center, s = mesh->quant_scale;
+  for (int done = 0; done < count; done += TRANSFORM_BLOCK) {
+    int n = count - done < TRANSFORM_BLOCK ? count - done : TRANSFORM_BLOCK;
+    if (quantized) {
+      for (int i = 0; i < n; i++) {
+        int16_t q[3];
+        memcpy(q, src + i * sizeof(q), sizeof(q));
+        x[i] = c.x + q[0] * s.x;
+        y[i] = c.y + q[1] * s.y;
+        z[i] = c.z + q[2] * s.z;
+      }
+      src += n * sizeof(int16_t[3]);
+    } else {
+      for (int i = 0; i < n; i++) {
+        float p[3];
+        memcpy(p, src + i * sizeof(p), sizeof(p));
+        x[i] = p[0];
+        y[i] = p[1];
+        z[i] = p[2];
+      }
+      src += n * sizeof(float[3]);
+    }
+    project_block(cam, x, y, z, n, projected + done, depths ? depths + done : NULL);
+  }
+}
+
+static inline int32_t clamp_coord(int64_t v) {
+  const int64_t limit = SCREEN_COORD_LIMIT;
+  return v > limit ? limit : (v < -limit ? -limit : (int32_t)v);
+}
+
+// The rows of a FixedView are below 2^14, they fit the halves of a word
+static inline uint32_t pack16(int32_t lo, int32_t hi) {
+  return (uint16_t)lo | (uint32_t)(uint16_t)hi << 16;
+}
+
+void transform_mesh_fixed(const FixedView *fv, const uint8_t *points, int count, int (*projected)[2], float *depths) {
+  const int32_t (*m)[3] = fv->m;
+  int base_shift = 62 + fv->xy_shift - fv->w_shift;
+#if TRANSFORM_DSP
+  const uint32_t r0 = pack16(m[0][0], m[0][1]), r1 = pack16(m[1][0], m[1][1]), r2 = pack16(m[2][0], m[2][1]);
+#endif
+  for (int i = 0; i < count; i++) {
+    const uint8_t *p = points + i * sizeof(int16_t[3]);
+#if TRANSFORM_DSP
+    // q[0] and q[1] are read as one word, __smlad multiplies both halves by
+    // the packed row and adds the q[2] term
+    uint32_t q01;
+    int16_t q2;
+    memcpy(&q01, p, sizeof(q01));
+    memcpy(&q2, p + sizeof(q01), sizeof(q2));
+    int32_t X = __smlad(r0, q01, m[0][2] * q2 + fv->b[0]);
+    int32_t Y = __smlad(r1, q01, m[1][2] * q2 + fv->b[1]);
+    int32_t W = __smlad(r2, q01, m[2][2] * q2 + fv->b[2]);
+#else
+    int16_t q[3];
+    memcpy(q, p, sizeof(q));
+    int32_t X = m[0][0] * q[0] + m[0][1] * q[1] + m[0][2] * q[2] + fv->b[0];
+    int32_t Y = m[1][0] * q[0] + m[1][1] * q[1] + m[1][2] * q[2] + fv->b[1];
+    int32_t W = m[2][0] * q[0] + m[2][1] * q[1] + m[2][2] * q[2] + fv->b[2];
+#endif
+    if (W < fv->near_w) {
+      projected[i][0] = CLIP_BEHIND;
+      if (depths) depths[i] = 1.0f / CAMERA_NEAR;
+      continue;
+    }
+
+    // X / W = X * r >> (62 - n), as in transform_and_project_fixed
+    int n;
+    uint32_t r = fixed_recip((uint32_t)W, &n);
+    int shift = base_shift - n;
+    if (shift < 0) shift = 0;
+    if (shift > 62) shift = 62;
+    projected[i][0] = clamp_coord(((int64_t)X * r) >> shift) + WIDTH / 2;
+    projected[i][1] = clamp_coord(((int64_t)Y * r) >> shift) + HEIGHT / 2;
+    // 1 / W from the same reciprocal, W being scaled by 2^w_shift
+    if (depths) depths[i] = fixed_to_float(r, n - 62 + fv->w_shift);
+  }
+}
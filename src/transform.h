@@ -0,0 +1,29 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "camera.h"
+#include "mesh.h"
+
+// Vertex transform kernels of the renderer. The float one decodes blocks of
+// TRANSFORM_BLOCK vertices into separate x, y and z arrays, so that each
+// stage is a loop without branches over one array: the compiler turns them
+// into SSE or NEON code on the host, and keeps the view in registers on the
+// device. The fixed point one keeps the int16 vertices as stored, its
+// reciprocal does not vectorize and the DSP extension multiplies two
+// halves of a word at once. This file is built with its own optimization
+// flags (see the Makefile), the rest of the app is built for size.
+//
+// They give the same results as transform_and_project and
+// transform_and_project_fixed (camera.c), which stay as the plain
+// references.
+#define TRANSFORM_BLOCK 32
+
+// Projection of count vertices of the mesh from first, read straight from
+// the model data, float or quantized. depths (1 / W, 1 / CAMERA_NEAR behind
+// the near plane) may be NULL.
+void transform_mesh(const Camera *cam, const Mesh *mesh, int first, int count, int (*projected)[2], float *depths);
+// transform_and_project_fixed with depths like transform_mesh. On cores
+// with the DSP extension the rows are packed 16 bit multiply accumulates.
+void transform_mesh_fixed(const FixedView *fv, const uint8_t *points, int count, int (*projected)[2], float *depths);
+
+#endif
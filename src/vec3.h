@@ -0,0 +1,8 @@
+#ifndef VEC3_H
+#define VEC3_H
+
+typedef struct {
+  float x, y, z;
+} Vec3;
+
+#endif